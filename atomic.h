@@ -0,0 +1,250 @@
+#pragma once
+
+#include "type_traits.h"
+
+namespace lib
+{
+
+enum class memory_order
+{
+    relaxed,
+    acquire,
+    release,
+    acq_rel,
+    seq_cst,
+};
+
+#ifdef _MSC_VER
+extern "C" long      _InterlockedCompareExchange(long volatile* target, long desired, long expected);
+extern "C" __int64   _InterlockedCompareExchange64(__int64 volatile* target, __int64 desired, __int64 expected);
+extern "C" long      _InterlockedExchangeAdd(long volatile* target, long value);
+extern "C" long      _InterlockedExchange(long volatile* target, long value);
+extern "C" void      _ReadWriteBarrier(void);
+#pragma intrinsic(_InterlockedCompareExchange, _InterlockedCompareExchange64, _InterlockedExchangeAdd, \
+                  _InterlockedExchange, _ReadWriteBarrier)
+
+// The 64-bit exchange and add are intrinsics on x64 only; 32-bit builds get 4-byte atomics.
+#ifdef _WIN64
+extern "C" __int64   _InterlockedExchangeAdd64(__int64 volatile* target, __int64 value);
+extern "C" __int64   _InterlockedExchange64(__int64 volatile* target, __int64 value);
+#pragma intrinsic(_InterlockedExchangeAdd64, _InterlockedExchange64)
+#endif
+
+namespace internal
+{
+template <size_t SIZE>
+struct _interlocked;
+
+template <>
+struct _interlocked<4>
+{
+    using type = long;
+    static type cas(volatile type* t, type d, type e) { return (_InterlockedCompareExchange(t, d, e)); }
+    static type add(volatile type* t, type v) { return (_InterlockedExchangeAdd(t, v)); }
+    static type xchg(volatile type* t, type v) { return (_InterlockedExchange(t, v)); }
+};
+
+#ifdef _WIN64
+template <>
+struct _interlocked<8>
+{
+    using type = __int64;
+    static type cas(volatile type* t, type d, type e) { return (_InterlockedCompareExchange64(t, d, e)); }
+    static type add(volatile type* t, type v) { return (_InterlockedExchangeAdd64(t, v)); }
+    static type xchg(volatile type* t, type v) { return (_InterlockedExchange64(t, v)); }
+};
+#endif
+}
+
+template <class T>
+class atomic
+{
+#ifdef _WIN64
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Unsupported size");
+#else
+    static_assert(sizeof(T) == 4, "Unsupported size");
+#endif
+    using op = internal::_interlocked<sizeof(T)>;
+    using raw_type = typename op::type;
+
+    volatile raw_type _value;
+
+    static raw_type to_raw(T value) noexcept { return ((raw_type)value); }
+    static T        from_raw(raw_type value) noexcept { return ((T)value); }
+
+public:
+    constexpr atomic(void) noexcept : _value() {}
+    constexpr atomic(T value) noexcept : _value((raw_type)value) {}
+    atomic(const atomic&) = delete;
+    atomic& operator=(const atomic&) = delete;
+
+    // x86/x64 volatile accesses are acquire/release under /volatile:ms.
+    T load(memory_order order = memory_order::seq_cst) const noexcept
+    {
+        (void)order;
+        const raw_type value = _value;
+        _ReadWriteBarrier();
+        return (from_raw(value));
+    }
+
+    void store(T value, memory_order order = memory_order::seq_cst) noexcept
+    {
+        if (order == memory_order::seq_cst)
+        {
+            op::xchg(&_value, to_raw(value));
+        }
+        else
+        {
+            _ReadWriteBarrier();
+            _value = to_raw(value);
+        }
+    }
+
+    T exchange(T value, memory_order order = memory_order::seq_cst) noexcept
+    {
+        (void)order;
+        return (from_raw(op::xchg(&_value, to_raw(value))));
+    }
+
+    bool compare_exchange_strong(T& expected, T desired, memory_order order = memory_order::seq_cst) noexcept
+    {
+        (void)order;
+        const raw_type prev = op::cas(&_value, to_raw(desired), to_raw(expected));
+        if (prev == to_raw(expected))
+        {
+            return (true);
+        }
+        expected = from_raw(prev);
+        return (false);
+    }
+
+    bool compare_exchange_weak(T& expected, T desired, memory_order order = memory_order::seq_cst) noexcept
+    {
+        return (compare_exchange_strong(expected, desired, order));
+    }
+
+    T fetch_add(T value, memory_order order = memory_order::seq_cst) noexcept
+    {
+        (void)order;
+        return (from_raw(op::add(&_value, to_raw(value))));
+    }
+
+    T fetch_sub(T value, memory_order order = memory_order::seq_cst) noexcept
+    {
+        (void)order;
+        return (from_raw(op::add(&_value, -to_raw(value))));
+    }
+};
+
+#elif defined __GNUC__
+
+namespace internal
+{
+constexpr int _to_builtin(memory_order order) noexcept
+{
+    return (order == memory_order::relaxed   ? __ATOMIC_RELAXED
+            : order == memory_order::acquire ? __ATOMIC_ACQUIRE
+            : order == memory_order::release ? __ATOMIC_RELEASE
+            : order == memory_order::acq_rel ? __ATOMIC_ACQ_REL
+                                             : __ATOMIC_SEQ_CST);
+}
+
+constexpr int _to_failure(memory_order order) noexcept
+{
+    return (order == memory_order::release   ? __ATOMIC_RELAXED
+            : order == memory_order::acq_rel ? __ATOMIC_ACQUIRE
+                                             : _to_builtin(order));
+}
+}
+
+template <class T>
+class atomic
+{
+    static_assert(sizeof(T) <= sizeof(void*), "Unsupported size");
+
+    T _value;
+
+public:
+    constexpr atomic(void) noexcept : _value() {}
+    constexpr atomic(T value) noexcept : _value(value) {}
+    atomic(const atomic&) = delete;
+    atomic& operator=(const atomic&) = delete;
+
+    T load(memory_order order = memory_order::seq_cst) const noexcept
+    {
+        return (__atomic_load_n(&_value, internal::_to_builtin(order)));
+    }
+
+    void store(T value, memory_order order = memory_order::seq_cst) noexcept
+    {
+        __atomic_store_n(&_value, value, internal::_to_builtin(order));
+    }
+
+    T exchange(T value, memory_order order = memory_order::seq_cst) noexcept
+    {
+        return (__atomic_exchange_n(&_value, value, internal::_to_builtin(order)));
+    }
+
+    bool compare_exchange_strong(T& expected, T desired, memory_order order = memory_order::seq_cst) noexcept
+    {
+        return (__atomic_compare_exchange_n(&_value, &expected, desired, false, internal::_to_builtin(order),
+                                            internal::_to_failure(order)));
+    }
+
+    bool compare_exchange_weak(T& expected, T desired, memory_order order = memory_order::seq_cst) noexcept
+    {
+        return (__atomic_compare_exchange_n(&_value, &expected, desired, true, internal::_to_builtin(order),
+                                            internal::_to_failure(order)));
+    }
+
+    T fetch_add(T value, memory_order order = memory_order::seq_cst) noexcept
+    {
+        return (__atomic_fetch_add(&_value, value, internal::_to_builtin(order)));
+    }
+
+    T fetch_sub(T value, memory_order order = memory_order::seq_cst) noexcept
+    {
+        return (__atomic_fetch_sub(&_value, value, internal::_to_builtin(order)));
+    }
+};
+
+#else
+#error not implemented
+#endif
+
+/** Test-and-test-and-set lock for short critical sections that must not enter the kernel. */
+class spin_lock
+{
+    atomic<unsigned int> _locked;
+
+public:
+    constexpr spin_lock(void) noexcept : _locked(0) {}
+    spin_lock(const spin_lock&) = delete;
+    spin_lock& operator=(const spin_lock&) = delete;
+
+    bool try_lock(void) noexcept { return (_locked.exchange(1, memory_order::acquire) == 0); }
+
+    void lock(void) noexcept
+    {
+        while (!try_lock())
+        {
+            while (_locked.load(memory_order::relaxed))
+            {}
+        }
+    }
+
+    void unlock(void) noexcept { _locked.store(0, memory_order::release); }
+};
+
+template <class Lock>
+class lock_guard
+{
+    Lock& _lock;
+
+public:
+    explicit lock_guard(Lock& lock) noexcept : _lock(lock) { _lock.lock(); }
+    ~lock_guard(void) noexcept { _lock.unlock(); }
+    lock_guard(const lock_guard&) = delete;
+    lock_guard& operator=(const lock_guard&) = delete;
+};
+}
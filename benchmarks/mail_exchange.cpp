@@ -0,0 +1,158 @@
+// Mails per second from one process to another, through a mail_exchange in a shared mapping and,
+// as the baseline, through a unix socketpair with write_mails and mail_stream_poller.
+// Both receivers sleep when idle: on the futex and in epoll_wait respectively. The exchange aims for
+// about 10M mails/s with sender and receiver on separate cores.
+//
+//     g++ -std=c++11 -O2 -Wall -Wextra -pthread -I.. mail_exchange.cpp && ./a.out
+
+#include "mail_ring_linux.h"
+#include "mail_stream_linux.h"
+#include "mailbox.h"
+#include "new.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr lib::size_t MAIL_COUNT = 4000000;
+constexpr lib::size_t BATCH      = 64;
+
+using exchange_type = lib::mail_exchange<1024>;
+using mailbox_type  = lib::mailbox<sizeof(mail), alignof(mail), 1024>;
+using poller_type   = lib::mail_stream_poller<64 * 1024, 1>;
+
+double seconds(void)
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9);
+}
+
+void fill(mail* batch)
+{
+    for (lib::size_t i = 0; i < BATCH; ++i)
+    {
+        batch[i].header         = {mail_address::A, mail_address::B, mail_subject::morning};
+        batch[i].body.morning.m = static_cast<int>(i);
+    }
+}
+
+bool report(const char* name, double start, pid_t child)
+{
+    int status = 0;
+    waitpid(child, &status, 0);
+    const double elapsed = seconds() - start;
+    const bool   passed  = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    printf("%-14s %zu mails in %.3f s: %6.2f M mails/s %s\n", name, MAIL_COUNT, elapsed,
+           static_cast<double>(MAIL_COUNT) / elapsed * 1e-6, passed ? "ok" : "FAILED");
+    return (passed);
+}
+
+bool run_exchange(void)
+{
+    void* const memory =
+        mmap(nullptr, sizeof(exchange_type), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        return (false);
+    }
+    exchange_type* const exchange = ::new (memory) exchange_type;
+
+    const double start = seconds();
+    const pid_t  child = fork();
+    if (child == 0)
+    {
+        mail        out[BATCH];
+        lib::size_t received = 0;
+        while (received < MAIL_COUNT)
+        {
+            const lib::size_t got = exchange->receive(mail_address::B, out, BATCH);
+            if (got == 0)
+            {
+                lib::wait_for_mail(*exchange, mail_address::B);
+            }
+            received += got;
+        }
+        _exit(0);
+    }
+
+    mail batch[BATCH];
+    fill(batch);
+    for (lib::size_t sent = 0; sent < MAIL_COUNT;)
+    {
+        const lib::size_t count = MAIL_COUNT - sent < BATCH ? MAIL_COUNT - sent : BATCH;
+        const lib::size_t done  = lib::send_mails(*exchange, mail_address::A, mail_address::B, batch, count);
+        if (done == 0)
+        {
+            sched_yield();
+        }
+        sent += done;
+    }
+
+    const bool passed = report("mail_exchange", start, child);
+    exchange->~exchange_type();
+    munmap(memory, sizeof(exchange_type));
+    return (passed);
+}
+
+bool run_socketpair(void)
+{
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+    {
+        return (false);
+    }
+
+    const double start = seconds();
+    const pid_t  child = fork();
+    if (child == 0)
+    {
+        close(pair[1]);
+        fcntl(pair[0], F_SETFL, O_NONBLOCK);
+        static mailbox_type inbox;
+        static poller_type  poller;
+        const lib::size_t   index = poller.add(pair[0]);
+        auto route = [](const mail_header&) -> mailbox_type* { return (&inbox); };
+
+        mailbox_type::message_type out;
+        lib::size_t                received = 0;
+        while (received < MAIL_COUNT)
+        {
+            const lib::size_t decoded = poller.poll(route, 1000);
+            while (inbox.fetch(out))
+            {
+                ++received;
+            }
+            if (decoded == 0 && !poller.open(index))
+            {
+                break;
+            }
+        }
+        _exit(received == MAIL_COUNT ? 0 : 1);
+    }
+
+    close(pair[0]);
+    mail batch[BATCH];
+    fill(batch);
+    for (lib::size_t sent = 0; sent < MAIL_COUNT; sent += BATCH)
+    {
+        lib::write_mails(pair[1], batch, MAIL_COUNT - sent < BATCH ? MAIL_COUNT - sent : BATCH);
+    }
+    close(pair[1]);
+    return (report("socketpair", start, child));
+}
+}
+
+int main(void)
+{
+    const bool exchange = run_exchange();
+    const bool stream   = run_socketpair();
+    return (exchange && stream ? 0 : 1);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "type_traits.h"
+
+namespace lib
+{
+
+using tick_t = uint64_t;
+
+/** Source of time for everything that measures or schedules. The unit of a tick is up to the clock. */
+struct iclock
+{
+    virtual ~iclock(void) = default;
+    virtual tick_t now(void) const = 0;
+};
+
+/** Source of a monotonically increasing count, e.g. a hardware performance counter. */
+struct icounter
+{
+    virtual ~icounter(void) = default;
+    virtual uint64_t read(void) const = 0;
+};
+}
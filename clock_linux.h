@@ -0,0 +1,81 @@
+#pragma once
+
+// Linux glue for clock.h. Unlike the rest of the library this header is hosted: it needs the
+// C library and kernel headers, so keep it out of freestanding (-nostdinc) builds.
+
+#include "clock.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace lib
+{
+
+/** CLOCK_MONOTONIC; a tick is a nanosecond. */
+class monotonic_clock : public iclock
+{
+public:
+    tick_t now(void) const override
+    {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (static_cast<tick_t>(time.tv_sec) * 1000000000u + static_cast<tick_t>(time.tv_nsec));
+    }
+};
+
+/**
+ * Hardware counter of the calling thread on whichever CPU it runs, through perf_event_open(2); user
+ * space only. Containers and perf_event_paranoid often refuse it: then valid() is false and read() is 0.
+ */
+class perf_counter : public icounter
+{
+    const int _fd;
+
+public:
+    enum class event
+    {
+        cache_misses,
+        branch_misses,
+    };
+
+    explicit perf_counter(event kind) noexcept : _fd(open_counter(kind)) {}
+
+    ~perf_counter(void) noexcept
+    {
+        if (_fd >= 0)
+        {
+            close(_fd);
+        }
+    }
+
+    perf_counter(const perf_counter&) = delete;
+    perf_counter& operator=(const perf_counter&) = delete;
+
+    bool valid(void) const noexcept { return (_fd >= 0); }
+
+    uint64_t read(void) const override
+    {
+        uint64_t value = 0;
+        if (_fd < 0 || ::read(_fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value)))
+        {
+            return (0);
+        }
+        return (value);
+    }
+
+private:
+    static int open_counter(event kind) noexcept
+    {
+        perf_event_attr attributes{};
+        attributes.size           = sizeof(attributes);
+        attributes.type           = PERF_TYPE_HARDWARE;
+        attributes.config         = kind == event::cache_misses ? PERF_COUNT_HW_CACHE_MISSES
+                                                                : PERF_COUNT_HW_BRANCH_MISSES;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv     = 1;
+        return (static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC)));
+    }
+};
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "atomic.h"
+#include "clock.h"
+#include "event_message.h"
+#include "state_machine.h"
+#include "type_traits.h"
+
+namespace lib
+{
+
+/**
+ * Earliest-deadline-first executor over MACHINES machines with DEPTH queued events each.
+ * Worker threads call run_one(); the machine whose queue holds the earliest deadline is served first.
+ * A machine is only ever run by one worker at a time and its events stay FIFO, so an urgent event
+ * raises the priority of the whole queue in front of it instead of overtaking it.
+ *
+ * Machine needs on_event(const ievent&) and accepts(event_id_t); events are stored by value in
+ * lib::message slots. An event posted to an idle machine whose current state does not accept it
+ * is dropped right away, since nothing queued ahead of it could change that state.
+ */
+template <class Machine, size_t MACHINES, size_t DEPTH, size_t SIZE, size_t ALIGN = alignof(max_align_t)>
+class deadline_scheduler
+{
+public:
+    using message_type = message<SIZE, ALIGN>;
+
+    static constexpr tick_t NO_DEADLINE = ~tick_t{0};
+
+private:
+    static constexpr size_t NPOS = ~size_t{0};
+
+    struct entry
+    {
+        tick_t                  deadline;
+        internal::_event_getter get;
+        message_type            data;
+    };
+
+    struct record
+    {
+        Machine* machine    = nullptr;
+        tick_t   key        = NO_DEADLINE; // Earliest deadline in the queue
+        size_t   heap_index = NPOS;
+        size_t   head       = 0;
+        size_t   count      = 0;
+        bool     running    = false;
+        entry    queue[DEPTH];
+    };
+
+    mutable spin_lock _lock;
+    record            _records[MACHINES];
+    size_t            _heap[MACHINES];
+    size_t            _heap_size = 0;
+    uint64_t          _dropped   = 0;
+
+public:
+    deadline_scheduler(void) noexcept = default;
+    deadline_scheduler(const deadline_scheduler&) = delete;
+    deadline_scheduler& operator=(const deadline_scheduler&) = delete;
+
+    /** Binds machine to index; posts to an index without a machine are rejected. */
+    void attach(size_t index, Machine& machine) noexcept
+    {
+        lock_guard<spin_lock> guard(_lock);
+        _records[index].machine = &machine;
+    }
+
+    uint64_t dropped(void) const noexcept
+    {
+        lock_guard<spin_lock> guard(_lock);
+        return (_dropped);
+    }
+
+    /**
+     * Queues event for the machine at index. Returns false when index is out of range, no machine is
+     * attached there yet, or its queue is full. An event dropped because the idle machine does not
+     * accept it still returns true; dropped() counts those.
+     */
+    template <class Event>
+    bool post(size_t index, Event&& event, tick_t deadline)
+    {
+        using decayed = decay_t<Event>;
+        constexpr internal::_event_getter get = &internal::_erased_event<decayed>::get;
+
+        if (index >= MACHINES)
+        {
+            return (false);
+        }
+        lock_guard<spin_lock> guard(_lock);
+        record&               target = _records[index];
+        if (!target.machine || target.count == DEPTH)
+        {
+            return (false);
+        }
+        if (target.count == 0 && !target.running &&
+            !target.machine->accepts(static_cast<const ievent&>(event).ID))
+        {
+            ++_dropped;
+            return (true);
+        }
+
+        entry& slot   = target.queue[(target.head + target.count) % DEPTH];
+        slot.deadline = deadline;
+        slot.get      = get;
+        slot.data     = forward<Event>(event);
+        ++target.count;
+
+        if (deadline < target.key)
+        {
+            target.key = deadline;
+            if (target.heap_index != NPOS)
+            {
+                sift_up(target.heap_index);
+            }
+        }
+        if (!target.running && target.heap_index == NPOS)
+        {
+            push(index);
+        }
+        return (true);
+    }
+
+    /** Runs the head event of the most urgent machine to completion; returns false when idle. */
+    bool run_one(void)
+    {
+        size_t                  index;
+        message_type            data;
+        internal::_event_getter get;
+        {
+            lock_guard<spin_lock> guard(_lock);
+            if (_heap_size == 0)
+            {
+                return (false);
+            }
+            index          = pop();
+            record& target = _records[index];
+            entry&  head   = target.queue[target.head];
+            get            = head.get;
+            data           = move(head.data);
+            target.head    = (target.head + 1) % DEPTH;
+            --target.count;
+            target.running = true;
+            target.key     = earliest(target);
+        }
+
+        _records[index].machine->on_event(get(data));
+
+        lock_guard<spin_lock> guard(_lock);
+        record&               target = _records[index];
+        target.running               = false;
+        if (target.count != 0)
+        {
+            push(index);
+        }
+        return (true);
+    }
+
+private:
+    static tick_t earliest(const record& target) noexcept
+    {
+        tick_t key = NO_DEADLINE;
+        for (size_t i = 0; i < target.count; ++i)
+        {
+            const tick_t deadline = target.queue[(target.head + i) % DEPTH].deadline;
+            key                   = deadline < key ? deadline : key;
+        }
+        return (key);
+    }
+
+    tick_t key_at(size_t position) const noexcept { return (_records[_heap[position]].key); }
+
+    void place(size_t position, size_t index) noexcept
+    {
+        _heap[position]            = index;
+        _records[index].heap_index = position;
+    }
+
+    void push(size_t index) noexcept
+    {
+        place(_heap_size, index);
+        sift_up(_heap_size++);
+    }
+
+    size_t pop(void) noexcept
+    {
+        const size_t top         = _heap[0];
+        _records[top].heap_index = NPOS;
+        if (--_heap_size != 0)
+        {
+            place(0, _heap[_heap_size]);
+            sift_down(0);
+        }
+        return (top);
+    }
+
+    void sift_up(size_t position) noexcept
+    {
+        const size_t index = _heap[position];
+        while (position != 0)
+        {
+            const size_t parent = (position - 1) / 2;
+            if (key_at(parent) <= _records[index].key)
+            {
+                break;
+            }
+            place(position, _heap[parent]);
+            position = parent;
+        }
+        place(position, index);
+    }
+
+    void sift_down(size_t position) noexcept
+    {
+        const size_t index = _heap[position];
+        for (;;)
+        {
+            size_t child = position * 2 + 1;
+            if (child >= _heap_size)
+            {
+                break;
+            }
+            if (child + 1 < _heap_size && key_at(child + 1) < key_at(child))
+            {
+                ++child;
+            }
+            if (_records[index].key <= key_at(child))
+            {
+                break;
+            }
+            place(position, _heap[child]);
+            position = child;
+        }
+        place(position, index);
+    }
+};
+}
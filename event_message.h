@@ -0,0 +1,23 @@
+#pragma once
+
+#include "mail_sender.h"
+#include "state_machine.h"
+#include "type_traits.h"
+
+namespace lib
+{
+namespace internal
+{
+/** Recovers the ievent held by a lib::message; queues store one next to each message they hold. */
+using _event_getter = const ievent& (*)(const _message&);
+
+template <class Event>
+struct _erased_event
+{
+    // is_constructible<const ievent&, const Event&> would accept any type: T(x) is a C-style cast for references.
+    static_assert(is_base_of<ievent, Event>::value, "Event must derive from ievent");
+
+    static const ievent& get(const _message& data) { return (*data._cast<const Event>()); }
+};
+}
+}
@@ -0,0 +1,159 @@
+// Instantiates every library class template, and calls each of their member templates, with
+// representative arguments, so the build type-checks their bodies and not only their declarations.
+// Nothing here is called at run time. Add new templates and member templates here as well.
+
+#include "deadline_scheduler.h"
+#include "latency_histogram.h"
+#include "load_generator.h"
+#include "mail.h"
+#include "mail_ring.h"
+#include "mail_sender.h"
+#include "mail_stream.h"
+#include "mailbox.h"
+#include "profile.h"
+#include "random.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "state_machine.h"
+#include "tagged_message.h"
+
+namespace instantiation
+{
+struct ping : lib::event_base<0>
+{};
+
+struct pong : lib::event_base<1>
+{};
+
+struct idle_state : lib::istate
+{
+    static constexpr lib::state_id_t ID = 0;
+    idle_state(void) : lib::istate{ID, ID, lib::make_event_set<ping>()} {}
+
+    lib::state_id_t on_event(const lib::ievent& event) override { return (event.ID == ping::ID ? 2 : ID); }
+};
+
+struct busy_state : lib::istate
+{
+    static constexpr lib::state_id_t ID = 2;
+    busy_state(void) : lib::istate{ID} {}
+
+    lib::state_id_t on_event(const lib::ievent& event) override { return (event.ID == pong::ID ? 0 : ID); }
+};
+
+struct table
+{
+    static constexpr lib::state_id_t COUNT = 3;
+
+    static lib::istate* const* states(void)
+    {
+        static idle_state                idle;
+        static lib::redirect_state<1, 2> routing;
+        static busy_state                busy;
+        static lib::istate* const        all[COUNT] = {&idle, &routing, &busy};
+        return (all);
+    }
+
+    static const lib::redirect_link* links(void)
+    {
+        static lib::redirect_link all[COUNT];
+        return (all);
+    }
+};
+
+using machine = lib::compact_state_machine<table, lib::hot_transitions<lib::hot_transition<idle_state, ping>>>;
+
+using mailbox_type = lib::mailbox<32, 8, 8, 2>;
+}
+
+template class lib::mailbox<32, 8, 8, 2>;
+template class lib::mail_ring<16>;
+template class lib::mail_exchange<16>;
+template class lib::latency_histogram<>;
+template class lib::synthetic_trace<4>;
+template class lib::deadline_scheduler<instantiation::machine, 4, 4, 16>;
+template class lib::simulation<instantiation::machine, 16, 16, alignof(lib::max_align_t), 8, 1>;
+template class lib::mail_decoder<256>;
+template class lib::transition_profile<instantiation::table::COUNT, 2>;
+template class lib::cow_pool<instantiation::machine, 10, 4, 8>;
+template class lib::tagged_message<lib::mail_registry>;
+
+namespace instantiation
+{
+struct mail_visitor
+{
+    template <class T>
+    void operator()(T&) const noexcept
+    {}
+};
+
+void instantiate_mailbox(mailbox_type& box)
+{
+    box.set_policy(static_cast<lib::size_t>(mail_subject::night), {1, true});
+    box.post(night_greeting{});
+    box.post(static_cast<lib::size_t>(mail_subject::morning), morning_greeting{});
+    box.post_emplace<evening_greeting>(static_cast<lib::size_t>(mail_subject::evening), [](evening_greeting&) {});
+
+    mailbox_type::message_type out;
+    lib::size_t                key;
+    box.fetch(out, &key);
+    lib::visit<morning_greeting, evening_greeting, night_greeting>(out, mail_visitor{});
+}
+
+void instantiate_mail_exchange(lib::mail_exchange<16>& exchange)
+{
+    mail out[4];
+    exchange.receive(mail_address::C, out, 4);
+}
+
+void instantiate_mail_decoder(lib::mail_decoder<256>& decoder, lib::mailbox<sizeof(mail), alignof(mail), 8>& box)
+{
+    decoder.decode([&box](const mail_header&) { return (&box); });
+}
+
+bool instantiate_tagged_message(lib::tagged_message<lib::mail_registry>& target)
+{
+    target.emplace<night_greeting>();
+    const lib::tagged_message<lib::mail_registry> copy = target;
+    const lib::tagged_message<lib::mail_registry> converted{morning_greeting{}};
+    return (target.valid() && lib::visit(copy, mail_visitor{}) && converted.valid());
+}
+
+lib::uint64_t instantiate_deadline_scheduler(lib::deadline_scheduler<machine, 4, 4, 16>& scheduler, machine& target)
+{
+    scheduler.attach(0, target);
+    scheduler.post(0, ping{}, 10);
+    scheduler.run_one();
+    return (scheduler.dropped());
+}
+
+using simulation_type = lib::simulation<machine, 16, 16, alignof(lib::max_align_t), 8, 1>;
+
+bool instantiate_simulation(simulation_type& simulation, machine& target)
+{
+    const bool scheduled = simulation.schedule(5, target, ping{}) && simulation.schedule(7, target, pong{});
+    simulation.run_until(6);
+    simulation.run();
+    return (scheduled);
+}
+
+double instantiate_load_generator(lib::load_generator& generator, lib::synthetic_trace<4>& trace, machine& target)
+{
+    auto dispatch = [&target](const lib::trace_record& record) {
+        if (record.kind == ping::ID)
+        {
+            target.on_event(ping{});
+        }
+    };
+    const lib::load_report steady  = generator.run(trace, dispatch);
+    const lib::load_report ceiling = generator.saturate(trace, dispatch, 2.0);
+    return (steady.throughput + ceiling.throughput);
+}
+
+void instantiate_transition_profile(const lib::transition_profile<table::COUNT, 2>& profile)
+{
+    static const char* const state_names[table::COUNT] = {"idle_state", "redirect_state", "busy_state"};
+    static const char* const event_names[2]            = {"ping", "pong"};
+    profile.write_hot_transitions([](const char*) {}, "hot", state_names, event_names, 0.9);
+}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "type_traits.h"
+
+namespace lib
+{
+
+/**
+ * Log-linear histogram of 64-bit values with a bounded relative error of 1 / 2^SUB_BITS.
+ * Recording is a handful of integer operations and never allocates.
+ */
+template <size_t SUB_BITS = 5>
+class latency_histogram
+{
+    static_assert(SUB_BITS > 0 && SUB_BITS < 16, "SUB_BITS is out of range");
+
+    static constexpr size_t SUB_COUNT    = size_t{1} << SUB_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    uint64_t _buckets[BUCKET_COUNT]{};
+    uint64_t _count = 0;
+    uint64_t _max   = 0;
+    uint64_t _min   = ~uint64_t{0};
+
+public:
+    void record(uint64_t value) noexcept
+    {
+        ++_buckets[index_of(value)];
+        ++_count;
+        _max = value > _max ? value : _max;
+        _min = value < _min ? value : _min;
+    }
+
+    void merge(const latency_histogram& rhs) noexcept
+    {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            _buckets[i] += rhs._buckets[i];
+        }
+        _count += rhs._count;
+        _max = rhs._max > _max ? rhs._max : _max;
+        _min = rhs._min < _min ? rhs._min : _min;
+    }
+
+    void reset(void) noexcept { *this = latency_histogram{}; }
+
+    uint64_t count(void) const noexcept { return (_count); }
+    uint64_t max(void) const noexcept { return (_max); }
+    uint64_t min(void) const noexcept { return (_count ? _min : 0); }
+
+    /** Upper bound of the bucket holding the given quantile, e.g. 0.999. Never exceeds max(). */
+    uint64_t percentile(double quantile) const noexcept
+    {
+        if (_count == 0)
+        {
+            return (0);
+        }
+        uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(_count) + 0.5);
+        rank          = rank == 0 ? 1 : rank > _count ? _count : rank;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            seen += _buckets[i];
+            if (seen >= rank)
+            {
+                const uint64_t upper = upper_of(i);
+                return (upper < _max ? upper : _max);
+            }
+        }
+        return (_max);
+    }
+
+private:
+    static size_t highest_bit(uint64_t value) noexcept
+    {
+#ifdef __GNUC__
+        return (63 - static_cast<size_t>(__builtin_clzll(value)));
+#else
+        size_t bit = 0;
+        while (value >>= 1)
+        {
+            ++bit;
+        }
+        return (bit);
+#endif
+    }
+
+    static size_t index_of(uint64_t value) noexcept
+    {
+        if (value < SUB_COUNT)
+        {
+            return (static_cast<size_t>(value));
+        }
+        const size_t shift = highest_bit(value) - SUB_BITS;
+        return ((shift + 1) * SUB_COUNT + static_cast<size_t>((value >> shift) - SUB_COUNT));
+    }
+
+    static uint64_t upper_of(size_t index) noexcept
+    {
+        if (index < SUB_COUNT)
+        {
+            return (index);
+        }
+        const size_t   shift    = index / SUB_COUNT - 1;
+        const uint64_t mantissa = index % SUB_COUNT + SUB_COUNT;
+        return (((mantissa + 1) << shift) - 1);
+    }
+};
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "clock.h"
+#include "latency_histogram.h"
+#include "random.h"
+#include "type_traits.h"
+
+namespace lib
+{
+
+struct trace_record
+{
+    tick_t at;      // Offset from the start of the trace
+    size_t machine; // Index of the target machine
+    size_t kind;    // Event kind, e.g. an ievent::ID or a mail_subject
+};
+
+struct itrace
+{
+    virtual ~itrace(void) = default;
+    virtual bool next(trace_record& record) = 0;
+    virtual void rewind(void) = 0;
+};
+
+/** Replays records captured from production. */
+class recorded_trace : public itrace
+{
+    const trace_record* const _records;
+    const size_t              _count;
+    size_t                    _position = 0;
+
+public:
+    recorded_trace(const trace_record* records, size_t count) noexcept : _records(records), _count(count) {}
+
+    bool next(trace_record& record) override
+    {
+        if (_position == _count)
+        {
+            return (false);
+        }
+        record = _records[_position++];
+        return (true);
+    }
+
+    void rewind(void) override { _position = 0; }
+};
+
+enum class arrival_process
+{
+    constant,
+    poisson,
+};
+
+/** Seeded synthetic traffic. weights[kind] is the relative frequency of each event kind. */
+template <size_t KINDS>
+class synthetic_trace : public itrace
+{
+    const uint64_t        _seed;
+    const size_t          _machines;
+    const double          _interval;
+    const arrival_process _process;
+    const size_t          _length;
+    uint64_t              _cumulative[KINDS]{};
+
+    xorshift _random;
+    double   _time      = 0.0;
+    size_t   _generated = 0;
+
+public:
+    synthetic_trace(uint64_t seed, size_t machines, tick_t mean_interval, arrival_process process,
+                    const uint64_t (&weights)[KINDS], size_t length) noexcept :
+        _seed(seed),
+        _machines(machines),
+        _interval(static_cast<double>(mean_interval)),
+        _process(process),
+        _length(length),
+        _random(seed)
+    {
+        uint64_t total = 0;
+        for (size_t i = 0; i < KINDS; ++i)
+        {
+            total += weights[i];
+            _cumulative[i] = total;
+        }
+    }
+
+    bool next(trace_record& record) override
+    {
+        if (_generated == _length)
+        {
+            return (false);
+        }
+        ++_generated;
+        _time += _process == arrival_process::constant ? _interval : _random.exponential(_interval);
+
+        record.at      = static_cast<tick_t>(_time);
+        record.machine = static_cast<size_t>(_random.below(_machines));
+        record.kind    = 0;
+
+        const uint64_t pick = _random.below(_cumulative[KINDS - 1]);
+        while (record.kind + 1 < KINDS && _cumulative[record.kind] <= pick)
+        {
+            ++record.kind;
+        }
+        return (true);
+    }
+
+    void rewind(void) override
+    {
+        _random    = xorshift{_seed};
+        _time      = 0.0;
+        _generated = 0;
+    }
+};
+
+struct load_report
+{
+    static constexpr size_t MAX_COUNTERS = 4;
+
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+    uint64_t count;
+    tick_t   elapsed;
+    double   throughput; // Completed events per tick
+    bool     saturated;  // The generator could not keep up with the schedule
+    uint64_t counters[MAX_COUNTERS];
+};
+
+/**
+ * Open-loop driver on the calling thread. The schedule comes from the trace alone, but dispatch is
+ * synchronous, so a slow dispatch delays every event after it. Latency is measured from each event's
+ * scheduled time rather than from when it was actually dispatched, so that delay is counted instead
+ * of hidden. Counters, e.g. perf_event_open(2) cache or branch misses supplied by the caller, are
+ * sampled around each run.
+ */
+class load_generator
+{
+    const iclock&   _clock;
+    icounter* const* _counters;
+    const size_t    _counter_count;
+    const tick_t    _slack;
+
+    latency_histogram<> _histogram;
+
+public:
+    /** A run is saturated when it ends more than slack ticks behind schedule. */
+    load_generator(const iclock& clock, tick_t slack, icounter* const* counters = nullptr,
+                   size_t counter_count = 0) noexcept :
+        _clock(clock),
+        _counters(counters),
+        _counter_count(counter_count < load_report::MAX_COUNTERS ? counter_count : load_report::MAX_COUNTERS),
+        _slack(slack)
+    {}
+
+    const latency_histogram<>& histogram(void) const noexcept { return (_histogram); }
+
+    /** Replays trace at speedup times its recorded rate; dispatch is called with each trace_record. */
+    template <class Dispatch>
+    load_report run(itrace& trace, Dispatch&& dispatch, double speedup = 1.0)
+    {
+        load_report report{};
+        _histogram.reset();
+        trace.rewind();
+
+        for (size_t i = 0; i < _counter_count; ++i)
+        {
+            report.counters[i] = _counters[i]->read();
+        }
+
+        const tick_t start     = _clock.now();
+        tick_t       scheduled = start;
+        trace_record record;
+        while (trace.next(record))
+        {
+            scheduled = start + static_cast<tick_t>(static_cast<double>(record.at) / speedup);
+            while (_clock.now() < scheduled)
+            {}
+            dispatch(record);
+            const tick_t done = _clock.now();
+            _histogram.record(done - scheduled);
+        }
+        const tick_t end = _clock.now();
+
+        for (size_t i = 0; i < _counter_count; ++i)
+        {
+            report.counters[i] = _counters[i]->read() - report.counters[i];
+        }
+
+        report.p50        = _histogram.percentile(0.5);
+        report.p99        = _histogram.percentile(0.99);
+        report.p999       = _histogram.percentile(0.999);
+        report.max        = _histogram.max();
+        report.count      = _histogram.count();
+        report.elapsed    = end - start;
+        report.throughput = report.elapsed ? static_cast<double>(report.count) / report.elapsed : 0.0;
+        report.saturated  = end - scheduled > _slack;
+        return (report);
+    }
+
+    /** Doubles the speedup until a run saturates and returns that run; its throughput is the ceiling. */
+    template <class Dispatch>
+    load_report saturate(itrace& trace, Dispatch&& dispatch, double speedup = 1.0, size_t max_steps = 32)
+    {
+        load_report report{};
+        for (size_t step = 0; step < max_steps; ++step, speedup *= 2.0)
+        {
+            report = run(trace, dispatch, speedup);
+            if (report.saturated)
+            {
+                break;
+            }
+        }
+        return (report);
+    }
+};
+}
@@ -1,13 +1,15 @@
 #pragma once
 
-enum class mail_address
+#include "type_traits.h"
+
+enum class mail_address : lib::uint8_t
 {
     A,
     B,
     C,
 };
 
-enum class mail_subject
+enum class mail_subject : lib::uint8_t
 {
     morning,
     evening,
@@ -15,6 +17,8 @@ enum class mail_subject
     night,
 };
 
+constexpr lib::size_t mail_subject_count = static_cast<lib::size_t>(mail_subject::night) + 1;
+
 struct morning_greeting
 {
     static constexpr mail_subject subject = mail_subject::morning;
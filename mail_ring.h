@@ -0,0 +1,203 @@
+#pragma once
+
+#include "atomic.h"
+#include "mail.h"
+#include "type_traits.h"
+
+namespace lib
+{
+
+/**
+ * Single-producer, single-consumer ring of mail.
+ * Holds no pointers, so it can be placed in a shared-memory segment mapped at a different address
+ * in each process. Writes are reserved and committed in batches; each commit is one release store.
+ */
+template <size_t CAPACITY>
+class mail_ring
+{
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+    static_assert(is_trivially_copyable<mail>::value, "mail must be trivially copyable");
+
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    // Producer line
+    alignas(64) atomic<size_t> _tail;
+    size_t _cached_head = 0;
+    // Consumer line
+    alignas(64) atomic<size_t> _head;
+    size_t _cached_tail = 0;
+
+    alignas(64) mail _slots[CAPACITY];
+
+public:
+    mail_ring(void) noexcept = default;
+    mail_ring(const mail_ring&) = delete;
+    mail_ring& operator=(const mail_ring&) = delete;
+
+    /** Producer side. Returns the number of contiguous slots from first, up to count. */
+    size_t reserve(mail*& first, size_t count) noexcept
+    {
+        const size_t tail = _tail.load(memory_order::relaxed);
+        if (tail - _cached_head + count > CAPACITY)
+        {
+            _cached_head = _head.load(memory_order::acquire);
+        }
+        const size_t free_count = CAPACITY - (tail - _cached_head);
+        const size_t contiguous = CAPACITY - (tail & MASK);
+
+        first = &_slots[tail & MASK];
+        return (min_of(min_of(count, free_count), contiguous));
+    }
+
+    /** Producer side. Publishes count reserved slots. */
+    void commit(size_t count) noexcept
+    {
+        _tail.store(_tail.load(memory_order::relaxed) + count, memory_order::seq_cst);
+    }
+
+    /** Consumer side. Returns the number of contiguous readable slots from first, up to count. */
+    size_t peek(const mail*& first, size_t count) noexcept
+    {
+        const size_t head = _head.load(memory_order::relaxed);
+        if (_cached_tail - head < count)
+        {
+            _cached_tail = _tail.load(memory_order::acquire);
+        }
+        const size_t used_count = _cached_tail - head;
+        const size_t contiguous = CAPACITY - (head & MASK);
+
+        first = &_slots[head & MASK];
+        return (min_of(min_of(count, used_count), contiguous));
+    }
+
+    /** Consumer side. Hands count peeked slots back to the producer. */
+    void release(size_t count) noexcept
+    {
+        _head.store(_head.load(memory_order::relaxed) + count, memory_order::release);
+    }
+
+    bool empty(void) const noexcept
+    {
+        return (_head.load(memory_order::seq_cst) == _tail.load(memory_order::seq_cst));
+    }
+
+private:
+    static size_t min_of(size_t lhs, size_t rhs) noexcept { return (lhs < rhs ? lhs : rhs); }
+};
+
+/**
+ * Shared-memory mail transport: one mail_ring per (from, to) pair, and one wake word per receiver.
+ * Construct it once in the segment; every process then uses it through its own mapping.
+ * The wake word is a 32-bit value suitable for futex(2) or WaitOnAddress, which are left to the caller,
+ * so a sender only pays for a system call when the receiver has declared itself idle.
+ */
+template <size_t CAPACITY, size_t ADDRESSES = static_cast<size_t>(mail_address::C) + 1>
+class mail_exchange
+{
+    struct receiver
+    {
+        alignas(64) atomic<unsigned int> waiting;
+        // Written by every receive, so kept off the line senders poll for waiting.
+        alignas(64) size_t next = 0; // Sender visited first by the next receive; receiver side only.
+        mail_ring<CAPACITY> from[ADDRESSES];
+    };
+
+    receiver _receivers[ADDRESSES];
+
+public:
+    mail_exchange(void) noexcept = default;
+    mail_exchange(const mail_exchange&) = delete;
+    mail_exchange& operator=(const mail_exchange&) = delete;
+
+    /**
+     * Copies as many of mails as fit and publishes them at once. Each mail must travel from -> to.
+     * Sets *wake when the receiver is idle and must be woken through wait_address(to).
+     */
+    size_t send(mail_address from, mail_address to, const mail* mails, size_t count, bool* wake = nullptr) noexcept
+    {
+        receiver&            target = _receivers[static_cast<size_t>(to)];
+        mail_ring<CAPACITY>& ring   = target.from[static_cast<size_t>(from)];
+
+        size_t sent = 0;
+        while (sent < count)
+        {
+            mail*        first    = nullptr;
+            const size_t reserved = ring.reserve(first, count - sent);
+            if (reserved == 0)
+            {
+                break;
+            }
+            for (size_t i = 0; i < reserved; ++i)
+            {
+                first[i] = mails[sent + i];
+            }
+            ring.commit(reserved);
+            sent += reserved;
+        }
+
+        const bool idle = sent != 0 && target.waiting.load(memory_order::seq_cst) != 0 &&
+                          target.waiting.exchange(0, memory_order::acq_rel) != 0;
+        if (wake)
+        {
+            *wake = idle;
+        }
+        return (sent);
+    }
+
+    /**
+     * Drains up to count mails addressed to to, visiting the senders in turn.
+     * Each call starts after the last sender served, so a busy sender cannot starve the others.
+     */
+    size_t receive(mail_address to, mail* out, size_t count) noexcept
+    {
+        receiver&    target   = _receivers[static_cast<size_t>(to)];
+        const size_t start    = target.next;
+        size_t       received = 0;
+        for (size_t turn = 0; turn < ADDRESSES && received < count; ++turn)
+        {
+            const size_t         from  = start + turn < ADDRESSES ? start + turn : start + turn - ADDRESSES;
+            mail_ring<CAPACITY>& ring  = target.from[from];
+            const mail*          first = nullptr;
+            size_t               ready = ring.peek(first, count - received);
+            while (ready != 0)
+            {
+                for (size_t i = 0; i < ready; ++i)
+                {
+                    out[received + i] = first[i];
+                }
+                ring.release(ready);
+                received += ready;
+                target.next = from + 1 < ADDRESSES ? from + 1 : 0;
+                ready       = ring.peek(first, count - received);
+            }
+        }
+        return (received);
+    }
+
+    /**
+     * Receiver side. Declares the receiver idle; returns false if mail arrived meanwhile.
+     * On true, sleep while *wait_address(to) == 1, then call end_wait.
+     */
+    bool prepare_wait(mail_address to) noexcept
+    {
+        receiver& target = _receivers[static_cast<size_t>(to)];
+        target.waiting.store(1, memory_order::seq_cst);
+        for (const mail_ring<CAPACITY>& ring : target.from)
+        {
+            if (!ring.empty())
+            {
+                target.waiting.store(0, memory_order::relaxed);
+                return (false);
+            }
+        }
+        return (true);
+    }
+
+    void end_wait(mail_address to) noexcept
+    {
+        _receivers[static_cast<size_t>(to)].waiting.store(0, memory_order::relaxed);
+    }
+
+    void* wait_address(mail_address to) noexcept { return (&_receivers[static_cast<size_t>(to)].waiting); }
+};
+}
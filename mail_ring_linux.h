@@ -0,0 +1,50 @@
+#pragma once
+
+// Linux glue for mail_ring.h. Unlike the rest of the library this header is hosted: it needs the
+// C library and kernel headers, so keep it out of freestanding (-nostdinc) builds.
+
+#include "mail_ring.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace lib
+{
+
+static_assert(sizeof(atomic<unsigned int>) == sizeof(unsigned int), "The wake word must be a plain futex word");
+
+/**
+ * Receiver side. Sleeps on the futex until a sender wakes the receiver, unless mail is already queued.
+ * The futex is not private, so the exchange may live in memory shared between processes.
+ */
+template <size_t CAPACITY, size_t ADDRESSES>
+void wait_for_mail(mail_exchange<CAPACITY, ADDRESSES>& exchange, mail_address to) noexcept
+{
+    if (!exchange.prepare_wait(to))
+    {
+        return;
+    }
+    unsigned int* const word = static_cast<unsigned int*>(exchange.wait_address(to));
+    // Returns at once when a sender cleared the word first; EINTR and spurious wake-ups go around again.
+    while (__atomic_load_n(word, __ATOMIC_ACQUIRE) == 1)
+    {
+        syscall(SYS_futex, word, FUTEX_WAIT, 1, nullptr, nullptr, 0);
+    }
+    exchange.end_wait(to);
+}
+
+/** Sender side. mail_exchange::send, followed by the futex wake-up when the receiver was idle. */
+template <size_t CAPACITY, size_t ADDRESSES>
+size_t send_mails(mail_exchange<CAPACITY, ADDRESSES>& exchange, mail_address from, mail_address to,
+                  const mail* mails, size_t count) noexcept
+{
+    bool         wake = false;
+    const size_t sent = exchange.send(from, to, mails, count, &wake);
+    if (wake)
+    {
+        syscall(SYS_futex, static_cast<unsigned int*>(exchange.wait_address(to)), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    }
+    return (sent);
+}
+}
@@ -59,17 +59,25 @@ constexpr _vtable_format create_vtable(void) noexcept
 };
 
 template <class T>
-constexpr _vtable_format* get_cached_vtable(void) noexcept
+struct _vtable_cache
 {
-    constexpr _vtable_format cache = create_vtable<T>();
-    return &cache;
+    static constexpr _vtable_format value = create_vtable<T>();
+};
+
+template <class T>
+constexpr _vtable_format _vtable_cache<T>::value;
+
+template <class T>
+constexpr const _vtable_format* get_cached_vtable(void) noexcept
+{
+    return (&_vtable_cache<T>::value);
 }
 
 class _message
 {
 private:
-    void* const               _buffer;
-    internal::_vtable_format* _invoker = nullptr;
+    void* const                     _buffer;
+    const internal::_vtable_format* _invoker = nullptr;
 
 public:
     bool has_value(void) const noexcept { return (_invoker); }
@@ -83,11 +91,30 @@ public:
         }
     }
 
-    // template <class T>
-    // T* _cast(void) const
-    // {
-    //     return (_invoker == get_cached_vtable<T>() ? static_cast<T*>(_buffer) : nullptr);
-    // }
+    /** One pointer comparison against the cached vtable of T. */
+    template <class T>
+    bool holds(void) const noexcept
+    {
+        return (_invoker == get_cached_vtable<remove_cv_t<T>>());
+    }
+
+    template <class T>
+    T* _cast(void) const noexcept
+    {
+        return (holds<T>() ? static_cast<T*>(_buffer) : nullptr);
+    }
+
+    template <class... Types, class Visitor>
+    bool _visit(Visitor& visitor)
+    {
+        return (_visit_as<Types...>(_buffer, visitor));
+    }
+
+    template <class... Types, class Visitor>
+    bool _visit(Visitor& visitor) const
+    {
+        return (_visit_as<const Types...>(_buffer, visitor));
+    }
 
 protected:
     explicit _message(char* buffer) noexcept : _buffer(buffer) {}
@@ -110,8 +137,8 @@ protected:
         if (rhs._invoker)
         {
             rhs._invoker->move_assign(rhs._buffer, _buffer);
-            _invoker     = rhs._invoker;
-            rhs._invoker = nullptr;
+            _invoker = rhs._invoker;
+            rhs.reset();
         }
     }
 
@@ -123,44 +150,89 @@ protected:
         new (_buffer) Decayed{forward<Args>(args)...};
         return (*static_cast<Decayed*>(_buffer));
     }
+
+private:
+    template <class T, class Visitor>
+    static void _visit_thunk(void* data, Visitor& visitor)
+    {
+        visitor(*static_cast<T*>(data));
+    }
+
+    // A vtable pointer carries no index into Types, so finding the payload type is a linear scan.
+    template <class... Qualified, class Visitor>
+    bool _visit_as(void* data, Visitor& visitor) const
+    {
+        using thunk = void (*)(void*, Visitor&);
+
+        static constexpr thunk                           thunks[]  = {&_visit_thunk<Qualified, Visitor>...};
+        static constexpr const internal::_vtable_format* vtables[] = {
+            get_cached_vtable<remove_const_t<Qualified>>()...};
+        for (size_t i = 0; i < sizeof...(Qualified); ++i)
+        {
+            if (_invoker == vtables[i])
+            {
+                thunks[i](data, visitor);
+                return (true);
+            }
+        }
+        return (false);
+    }
 };
 }
 
-// template <class T>
-// T* any_cast(internal::_message* target) noexcept
-// {
-//     return (target ? target->_cast<T>() : nullptr);
-// }
+/**
+ * Calls visitor with the payload if it is one of Types; no RTTI is involved.
+ * Returns false when the message is empty or holds another type.
+ * The type is found by comparing the vtable pointer against each of Types in turn, so the cost is
+ * O(sizeof...(Types)). tagged_message dispatches through a jump table in O(1) instead.
+ */
+template <class... Types, class Visitor>
+bool visit(internal::_message& target, Visitor&& visitor)
+{
+    return (target._visit<Types...>(visitor));
+}
 
-// template <class T>
-// const T* any_cast(const internal::_message* target) noexcept
-// {
-//     return (target ? target->_cast<T>() : nullptr);
-// }
+template <class... Types, class Visitor>
+bool visit(const internal::_message& target, Visitor&& visitor)
+{
+    return (target._visit<Types...>(visitor));
+}
 
-// template <class T>
-// T any_cast(internal::_message& target)
-// {
-//     using U = remove_cvref_t<T>;
-//     static_assert(is_constructible<T, const U&>::value, "T is not constructible");
-//     return (*any_cast<U>(&target));
-// }
+template <class T>
+T* any_cast(internal::_message* target) noexcept
+{
+    return (target ? target->_cast<T>() : nullptr);
+}
 
-// template <class T>
-// T any_cast(const internal::_message& target)
-// {
-//     using U = remove_cvref_t<T>;
-//     static_assert(is_constructible<T, U&>::value, "T is not constructible");
-//     return (*any_cast<U>(&target));
-// }
+template <class T>
+const T* any_cast(const internal::_message* target) noexcept
+{
+    return (target ? target->_cast<const T>() : nullptr);
+}
 
-// template <class T>
-// T any_cast(internal::_message&& target)
-// {
-//     using U = remove_cvref_t<T>;
-//     static_assert(is_constructible<T, U>::value, "T is not constructible");
-//     return (move(*any_cast<U>(&target)));
-// }
+template <class T>
+T any_cast(internal::_message& target)
+{
+    using U = remove_cvref_t<T>;
+    static_assert(is_constructible<T, U&>::value, "T is not constructible");
+    return (*any_cast<U>(&target));
+}
+
+template <class T>
+T any_cast(const internal::_message& target)
+{
+    using U = remove_cvref_t<T>;
+    static_assert(is_constructible<T, const U&>::value, "T is not constructible");
+    return (*any_cast<U>(&target));
+}
+
+template <class T>
+T any_cast(internal::_message&& target)
+{
+    using U = remove_cvref_t<T>;
+    static_assert(is_constructible<T, U>::value, "T is not constructible");
+    return (move(*any_cast<U>(&target)));
+}
 
 template <size_t SIZE, size_t ALIGN = alignof(max_align_t)>
 class message : public internal::_message
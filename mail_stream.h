@@ -0,0 +1,188 @@
+#pragma once
+
+#include "mail.h"
+#include "type_traits.h"
+
+namespace lib
+{
+
+/**
+ * Wire format of a mail: the 3-byte mail_header followed by the body member named by its subject.
+ * Any byte stream works (pipe, unix socket, file); the event loop that polls the descriptors
+ * (epoll or io_uring) stays with the caller, which only moves bytes in and out of these buffers.
+ */
+inline size_t mail_body_size(mail_subject subject) noexcept
+{
+    switch (subject)
+    {
+    case mail_subject::morning:
+        return (sizeof(morning_greeting));
+    case mail_subject::evening:
+        return (sizeof(evening_greeting));
+    case mail_subject::afternoon:
+        return (sizeof(afternoon_greeting));
+    case mail_subject::night:
+        return (sizeof(night_greeting));
+    }
+    return (0);
+}
+
+inline size_t mail_frame_size(const mail& target) noexcept
+{
+    return (sizeof(mail_header) + mail_body_size(target.header.subject));
+}
+
+namespace internal
+{
+inline void _copy_bytes(void* dst, const void* src, size_t size) noexcept
+{
+    char* const       to   = static_cast<char*>(dst);
+    const char* const from = static_cast<const char*>(src);
+    for (size_t i = 0; i < size; ++i)
+    {
+        to[i] = from[i];
+    }
+}
+}
+
+/**
+ * Reassembles frames from a byte stream and posts each one as a whole mail, keyed by its subject,
+ * straight into the target mailbox slot, so receivers still see header.from. Target mailboxes need
+ * SIZE >= sizeof(mail) and a key per mail_subject.
+ * Read into prepare() and commit() what arrived, then decode().
+ */
+template <size_t CAPACITY>
+class mail_decoder
+{
+    static_assert(CAPACITY >= sizeof(mail_header) + sizeof(mail_body), "CAPACITY cannot hold a frame");
+
+    char   _buffer[CAPACITY];
+    size_t _begin   = 0;
+    size_t _end     = 0;
+    bool   _corrupt = false;
+    bool   _blocked = false;
+
+public:
+    /** Space for the next read; *space receives its size. */
+    char* prepare(size_t* space) noexcept
+    {
+        if (_begin != 0)
+        {
+            internal::_copy_bytes(_buffer, _buffer + _begin, _end - _begin);
+            _end -= _begin;
+            _begin = 0;
+        }
+        *space = CAPACITY - _end;
+        return (_buffer + _end);
+    }
+
+    void commit(size_t size) noexcept { _end += size; }
+
+    /** Set once an unknown subject is seen; the stream cannot be resynchronised. */
+    bool corrupt(void) const noexcept { return (_corrupt); }
+
+    /** Set when the last decode stopped at a full mailbox; the next decode can continue without new input. */
+    bool blocked(void) const noexcept { return (_blocked); }
+
+    /**
+     * Decodes complete frames. route(header) returns the mailbox of header.to, or nullptr to drop the frame.
+     * Stops early when a mailbox is full, keeping that frame for the next call. Returns the frames consumed.
+     */
+    template <class Route>
+    size_t decode(Route&& route)
+    {
+        size_t frames = 0;
+        _blocked      = false;
+        while (!_corrupt && _end - _begin >= sizeof(mail_header))
+        {
+            mail_header header;
+            internal::_copy_bytes(&header, _buffer + _begin, sizeof(header));
+            const size_t body_size = mail_body_size(header.subject);
+            if (body_size == 0)
+            {
+                _corrupt = true;
+                break;
+            }
+            if (_end - _begin < sizeof(header) + body_size)
+            {
+                break;
+            }
+
+            const char* const body   = _buffer + _begin + sizeof(header);
+            auto* const       target = route(header);
+            if (target && !post(*target, header, body, body_size))
+            {
+                _blocked = true;
+                break;
+            }
+            _begin += sizeof(header) + body_size;
+            ++frames;
+        }
+        return (frames);
+    }
+
+private:
+    template <class Mailbox>
+    static bool post(Mailbox& target, const mail_header& header, const char* body, size_t body_size)
+    {
+        static_assert(Mailbox::KEY_COUNT >= mail_subject_count, "Mailbox needs a key for every mail_subject");
+
+        return (target.template post_emplace<mail>(static_cast<size_t>(header.subject),
+                                                    filler{header, body, body_size}));
+    }
+
+    struct filler
+    {
+        const mail_header& header;
+        const char*        body;
+        size_t             body_size;
+
+        void operator()(mail& out) const noexcept
+        {
+            out.header = header;
+            internal::_copy_bytes(&out.body, body, body_size);
+        }
+    };
+};
+
+/** Same layout as struct iovec, so an array of them can be passed to writev(2) or io_uring as-is. */
+struct io_segment
+{
+    const void* base;
+    size_t      length;
+};
+
+/**
+ * Describes mails as gather segments pointing into the mails themselves, two per mail.
+ * Returns how many mails fit in max_segments; *segment_count receives the segments used.
+ */
+inline size_t gather_mails(const mail* mails, size_t count, io_segment* segments, size_t max_segments,
+                           size_t* segment_count) noexcept
+{
+    size_t used = 0;
+    size_t sent = 0;
+    for (; sent < count && used + 2 <= max_segments; ++sent)
+    {
+        segments[used++] = {&mails[sent].header, sizeof(mail_header)};
+        segments[used++] = {&mails[sent].body, mail_body_size(mails[sent].header.subject)};
+    }
+    *segment_count = used;
+    return (sent);
+}
+
+/** Drops written bytes from the front of segments after a short write. */
+inline void advance_segments(io_segment*& segments, size_t& count, size_t written) noexcept
+{
+    while (count != 0 && written >= segments->length)
+    {
+        written -= segments->length;
+        ++segments;
+        --count;
+    }
+    if (count != 0)
+    {
+        segments->base = static_cast<const char*>(segments->base) + written;
+        segments->length -= written;
+    }
+}
+}
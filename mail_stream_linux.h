@@ -0,0 +1,227 @@
+#pragma once
+
+// Linux glue for mail_stream.h. Unlike the rest of the library this header is hosted: it needs the
+// C library and kernel headers, so keep it out of freestanding (-nostdinc) builds.
+
+#include "mail_stream.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace lib
+{
+
+static_assert(sizeof(io_segment) == sizeof(iovec), "io_segment must match struct iovec");
+
+/**
+ * Owns an epoll set of up to STREAMS readable descriptors (sockets, pipes), each with its own
+ * mail_decoder of CAPACITY bytes. poll() waits for readiness, reads each ready descriptor until it
+ * would block, filling as much of the decoder buffer as the kernel has, and decodes every complete
+ * frame into the mailbox chosen by route(header).
+ *
+ * Descriptors stay owned by the caller and must be non-blocking. A stream that reaches end of file,
+ * fails or turns corrupt leaves the epoll set on its own; frames it already buffered are still
+ * delivered. remove() frees its slot.
+ */
+template <size_t CAPACITY, size_t STREAMS>
+class mail_stream_poller
+{
+public:
+    static constexpr size_t NPOS = ~size_t{0};
+
+private:
+    static constexpr int BATCH = 64;
+
+    struct stream
+    {
+        int                    fd      = -1;
+        bool                   watched = false;
+        mail_decoder<CAPACITY> decoder;
+    };
+
+    const int _epoll;
+    stream    _streams[STREAMS];
+    size_t    _watched = 0;
+
+public:
+    mail_stream_poller(void) noexcept : _epoll(epoll_create1(EPOLL_CLOEXEC)) {}
+
+    ~mail_stream_poller(void) noexcept
+    {
+        if (_epoll >= 0)
+        {
+            close(_epoll);
+        }
+    }
+
+    mail_stream_poller(const mail_stream_poller&) = delete;
+    mail_stream_poller& operator=(const mail_stream_poller&) = delete;
+
+    /** False when the epoll instance could not be created. */
+    bool valid(void) const noexcept { return (_epoll >= 0); }
+
+    /** Starts reading fd; returns its stream index, or NPOS when every slot is taken or epoll refuses fd. */
+    size_t add(int fd) noexcept
+    {
+        for (size_t i = 0; i < STREAMS; ++i)
+        {
+            stream& target = _streams[i];
+            if (target.fd >= 0)
+            {
+                continue;
+            }
+            epoll_event event{};
+            event.events   = EPOLLIN;
+            event.data.u64 = i;
+            if (epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+            {
+                return (NPOS);
+            }
+            target.fd      = fd;
+            target.watched = true;
+            ++_watched;
+            target.decoder = mail_decoder<CAPACITY>{};
+            return (i);
+        }
+        return (NPOS);
+    }
+
+    /** Stops reading the stream and drops whatever it still buffers. The descriptor is not closed. */
+    void remove(size_t index) noexcept
+    {
+        stop(_streams[index]);
+        _streams[index].fd = -1;
+    }
+
+    /** False once the stream hit end of file, an error or corruption. */
+    bool open(size_t index) const noexcept { return (_streams[index].watched); }
+
+    bool corrupt(size_t index) const noexcept { return (_streams[index].decoder.corrupt()); }
+
+    /**
+     * Retries streams held back by a full mailbox, then waits up to timeout_ms (-1: forever) for input
+     * and drains every ready stream. Does not wait while a stream is still held back or when no stream is open.
+     * Returns the frames decoded.
+     */
+    template <class Route>
+    size_t poll(Route&& route, int timeout_ms)
+    {
+        size_t frames  = 0;
+        bool   blocked = false;
+        for (stream& target : _streams)
+        {
+            if (target.fd >= 0 && target.decoder.blocked())
+            {
+                frames += drain(target, route);
+                blocked = blocked || target.decoder.blocked();
+            }
+        }
+
+        if (_watched == 0)
+        {
+            return (frames);
+        }
+        epoll_event events[BATCH];
+        const int   ready = epoll_wait(_epoll, events, BATCH, blocked ? 0 : timeout_ms);
+        for (int i = 0; i < ready; ++i)
+        {
+            frames += drain(_streams[events[i].data.u64], route);
+        }
+        return (frames);
+    }
+
+private:
+    template <class Route>
+    size_t drain(stream& target, Route& route)
+    {
+        size_t frames = 0;
+        for (;;)
+        {
+            frames += target.decoder.decode(route);
+            if (target.decoder.corrupt())
+            {
+                stop(target);
+                break;
+            }
+            if (!target.watched)
+            {
+                break;
+            }
+
+            size_t      space = 0;
+            char* const begin = target.decoder.prepare(&space);
+            if (space == 0)
+            {
+                // The buffer is full of frames the mailboxes cannot take yet; read(2) of 0 bytes would look like EOF.
+                break;
+            }
+            const ssize_t got = read(target.fd, begin, space);
+            if (got > 0)
+            {
+                target.decoder.commit(static_cast<size_t>(got));
+                continue;
+            }
+            if (got < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+            stop(target);
+        }
+        return (frames);
+    }
+
+    void stop(stream& target) noexcept
+    {
+        if (target.watched)
+        {
+            epoll_ctl(_epoll, EPOLL_CTL_DEL, target.fd, nullptr);
+            target.watched = false;
+            --_watched;
+        }
+    }
+};
+
+/**
+ * Writes mails to fd as frames, up to 32 mails per writev(2) straight from the mails themselves.
+ * When a non-blocking fd is full it waits for room with poll(2).
+ * Returns false on a write error, after which the stream may end in the middle of a frame.
+ */
+inline bool write_mails(int fd, const mail* mails, size_t count) noexcept
+{
+    size_t done = 0;
+    while (done < count)
+    {
+        io_segment   segments[64];
+        size_t       segment_count = 0;
+        const size_t gathered      = gather_mails(mails + done, count - done, segments, 64, &segment_count);
+        io_segment*  next          = segments;
+        while (segment_count != 0)
+        {
+            const ssize_t written = writev(fd, reinterpret_cast<const iovec*>(next), static_cast<int>(segment_count));
+            if (written >= 0)
+            {
+                advance_segments(next, segment_count, static_cast<size_t>(written));
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                pollfd room{fd, POLLOUT, 0};
+                ::poll(&room, 1, -1);
+            }
+            else if (errno != EINTR)
+            {
+                return (false);
+            }
+        }
+        done += gathered;
+    }
+    return (true);
+}
+}
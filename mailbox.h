@@ -0,0 +1,274 @@
+#pragma once
+
+#include "atomic.h"
+#include "mail.h"
+#include "mail_sender.h"
+#include "type_traits.h"
+
+namespace lib
+{
+
+struct mailbox_policy
+{
+    size_t lane;     // 0 is served first.
+    bool   coalesce; // A newer post overwrites the still queued one in place.
+};
+
+namespace internal
+{
+template <class T, class = void>
+struct _has_subject : false_type
+{};
+
+template <class T>
+struct _has_subject<T, void_t<decltype(T::subject)>> : true_type
+{};
+
+template <class T, class = void>
+struct _mailbox_key
+{
+    static constexpr size_t value = static_cast<size_t>(T::ID);
+};
+
+template <class T>
+struct _mailbox_key<T, enable_if_t<_has_subject<T>::value>>
+{
+    static constexpr size_t value = static_cast<size_t>(T::subject);
+};
+}
+
+/**
+ * Multi-producer, single-consumer bounded mailbox.
+ * Every key (ievent::ID or mail_subject) is routed to a lane by its policy; each lane is FIFO and
+ * lower lanes are fetched first. Neither post nor fetch ever waits on another thread.
+ * Keys must be below KEYS; posts with larger runtime keys are rejected.
+ */
+template <size_t SIZE, size_t ALIGN, size_t CAPACITY, size_t LANES = 1, size_t KEYS = mail_subject_count>
+class mailbox
+{
+public:
+    using message_type = message<SIZE, ALIGN>;
+
+    static constexpr size_t KEY_COUNT = KEYS;
+
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+    static_assert(LANES > 0, "At least one lane is required");
+    static_assert(KEYS > 0, "At least one key is required");
+
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    // The slot state carries its ticket, so a stale coalescing attempt fails its CAS.
+    enum : size_t
+    {
+        FREE,
+        PUBLISHED,
+        REWRITING,
+        READING,
+        PHASES,
+    };
+
+    struct slot
+    {
+        atomic<size_t> state;
+        size_t         key = 0;
+        message_type   data;
+    };
+
+    struct lane
+    {
+        alignas(64) atomic<size_t> tail;
+        alignas(64) size_t head = 0;
+        slot ring[CAPACITY];
+    };
+
+    lane           _lanes[LANES];
+    atomic<size_t> _pending[KEYS]; // Ticket + 1 of the latest queued coalescable post, 0 if none.
+    mailbox_policy _policies[KEYS]{};
+
+public:
+    mailbox(void) noexcept
+    {
+        for (lane& target : _lanes)
+        {
+            for (size_t i = 0; i < CAPACITY; ++i)
+            {
+                target.ring[i].state.store(i * PHASES + FREE, memory_order::relaxed);
+            }
+        }
+    }
+
+    mailbox(const mailbox&) = delete;
+    mailbox& operator=(const mailbox&) = delete;
+
+    /** Must be configured before the key is posted; returns false when key is out of range. */
+    bool set_policy(size_t key, mailbox_policy policy) noexcept
+    {
+        if (key >= KEYS)
+        {
+            return (false);
+        }
+        _policies[key] = {policy.lane < LANES ? policy.lane : LANES - 1, policy.coalesce};
+        return (true);
+    }
+
+    mailbox_policy get_policy(size_t key) const noexcept { return (key < KEYS ? _policies[key] : mailbox_policy{}); }
+
+    template <class T>
+    bool post(T&& data)
+    {
+        static_assert(internal::_mailbox_key<decay_t<T>>::value < KEYS, "The key of T must be below KEYS");
+        return (post(internal::_mailbox_key<decay_t<T>>::value, forward<T>(data)));
+    }
+
+    /** Returns false when the lane of the key is full or key is out of range. */
+    template <class T>
+    bool post(size_t key, T&& data)
+    {
+        if (key >= KEYS)
+        {
+            return (false);
+        }
+        const mailbox_policy& policy = _policies[key];
+        lane&                 target = _lanes[policy.lane];
+
+        // write runs once, on whichever slot ends up published.
+        auto write = [&data](message_type& slot) { slot = forward<T>(data); };
+        return (publish(target, key, policy.coalesce, write));
+    }
+
+    /** Constructs a T in the queued slot and lets fill write it in place before it is published. */
+    template <class T, class Fill>
+    bool post_emplace(size_t key, Fill&& fill)
+    {
+        if (key >= KEYS)
+        {
+            return (false);
+        }
+        const mailbox_policy& policy = _policies[key];
+        lane&                 target = _lanes[policy.lane];
+
+        auto write = [&fill](message_type& slot) { fill(slot.template emplace<T>()); };
+        return (publish(target, key, policy.coalesce, write));
+    }
+
+    /** Consumer side only. */
+    bool fetch(message_type& out, size_t* key = nullptr)
+    {
+        for (lane& target : _lanes)
+        {
+            if (dequeue(target, out, key))
+            {
+                return (true);
+            }
+        }
+        return (false);
+    }
+
+    /** Consumer side only. */
+    bool empty(void) const noexcept
+    {
+        for (const lane& target : _lanes)
+        {
+            const size_t state = target.ring[target.head & MASK].state.load(memory_order::acquire);
+            if (state != target.head * PHASES + FREE)
+            {
+                return (false);
+            }
+        }
+        return (true);
+    }
+
+private:
+    template <class Writer>
+    bool publish(lane& target, size_t key, bool coalesce, Writer& write)
+    {
+        return ((coalesce && overwrite(target, key, write)) || enqueue(target, key, coalesce, write));
+    }
+
+    template <class Writer>
+    bool overwrite(lane& target, size_t key, Writer& write)
+    {
+        const size_t pending = _pending[key].load(memory_order::acquire);
+        if (pending == 0)
+        {
+            return (false);
+        }
+
+        const size_t ticket   = pending - 1;
+        slot&        current  = target.ring[ticket & MASK];
+        size_t       expected = ticket * PHASES + PUBLISHED;
+        if (!current.state.compare_exchange_strong(expected, ticket * PHASES + REWRITING, memory_order::acquire))
+        {
+            return (false);
+        }
+        write(current.data);
+        current.state.store(ticket * PHASES + PUBLISHED, memory_order::release);
+        return (true);
+    }
+
+    template <class Writer>
+    bool enqueue(lane& target, size_t key, bool coalesce, Writer& write)
+    {
+        size_t ticket = target.tail.load(memory_order::relaxed);
+        for (;;)
+        {
+            const size_t   state = target.ring[ticket & MASK].state.load(memory_order::acquire);
+            const intptr_t diff  = static_cast<intptr_t>(state - ticket * PHASES);
+            if (diff == 0)
+            {
+                if (target.tail.compare_exchange_weak(ticket, ticket + 1, memory_order::relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return (false);
+            }
+            else
+            {
+                ticket = target.tail.load(memory_order::relaxed);
+            }
+        }
+
+        slot& current = target.ring[ticket & MASK];
+        current.key   = key;
+        write(current.data);
+        current.state.store(ticket * PHASES + PUBLISHED, memory_order::release);
+
+        if (coalesce)
+        {
+            size_t pending = _pending[key].load(memory_order::relaxed);
+            while (pending < ticket + 1 &&
+                   !_pending[key].compare_exchange_weak(pending, ticket + 1, memory_order::release))
+            {}
+        }
+        return (true);
+    }
+
+    bool dequeue(lane& target, message_type& out, size_t* key)
+    {
+        const size_t ticket   = target.head;
+        slot&        current  = target.ring[ticket & MASK];
+        size_t       expected = ticket * PHASES + PUBLISHED;
+        // Also fails while a producer is rewriting the head; the next fetch will pick it up.
+        if (!current.state.compare_exchange_strong(expected, ticket * PHASES + READING, memory_order::acquire))
+        {
+            return (false);
+        }
+
+        out = move(current.data);
+        if (key)
+        {
+            *key = current.key;
+        }
+        size_t pending = ticket + 1;
+        _pending[current.key].compare_exchange_strong(pending, 0, memory_order::relaxed);
+
+        current.state.store((ticket + CAPACITY) * PHASES + FREE, memory_order::release);
+        target.head = ticket + 1;
+        return (true);
+    }
+};
+}
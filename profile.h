@@ -0,0 +1,141 @@
+#pragma once
+
+#include "state_machine.h"
+#include "type_traits.h"
+
+namespace lib
+{
+
+struct hot_entry
+{
+    state_id_t state_id;
+    event_id_t event_id;
+    uint64_t   count;
+};
+
+/**
+ * Transition-frequency profile of STATES x EVENTS counters. Not synchronised: keep one per thread
+ * and merge them. Events with IDs of EVENTS or more are not counted.
+ */
+template <size_t STATES, size_t EVENTS>
+class transition_profile : public iprofile
+{
+    uint64_t _counts[STATES][EVENTS]{};
+    uint64_t _total = 0;
+
+public:
+    void record(state_id_t state_id, event_id_t event_id) override
+    {
+        if (state_id < STATES && event_id < EVENTS)
+        {
+            ++_counts[state_id][event_id];
+            ++_total;
+        }
+    }
+
+    void merge(const transition_profile& rhs) noexcept
+    {
+        for (size_t s = 0; s < STATES; ++s)
+        {
+            for (size_t e = 0; e < EVENTS; ++e)
+            {
+                _counts[s][e] += rhs._counts[s][e];
+            }
+        }
+        _total += rhs._total;
+    }
+
+    uint64_t count(state_id_t state_id, event_id_t event_id) const noexcept { return (_counts[state_id][event_id]); }
+    uint64_t total(void) const noexcept { return (_total); }
+
+    /**
+     * Writes the hottest pairs to out, hottest first, until they cover the given share of all
+     * dispatches or max entries are written. Returns the number written.
+     */
+    size_t hottest(hot_entry* out, size_t max, double coverage) const noexcept
+    {
+        const uint64_t goal    = static_cast<uint64_t>(coverage * static_cast<double>(_total));
+        uint64_t       covered = 0;
+        size_t         written = 0;
+        while (written < max && covered < goal)
+        {
+            hot_entry best{0, 0, 0};
+            for (size_t s = 0; s < STATES; ++s)
+            {
+                for (size_t e = 0; e < EVENTS; ++e)
+                {
+                    if (_counts[s][e] > best.count && !listed(out, written, s, e))
+                    {
+                        best = {s, e, _counts[s][e]};
+                    }
+                }
+            }
+            if (best.count == 0)
+            {
+                break;
+            }
+            out[written++] = best;
+            covered += best.count;
+        }
+        return (written);
+    }
+
+    /**
+     * Emits a header for the rebuild step:
+     *
+     *     using <alias> = lib::hot_transitions<
+     *         lib::hot_transition<state_type, event_type>, // count
+     *         ...>;
+     *
+     * state_names[id] and event_names[id] give the C++ type of each ID. write receives the text in pieces.
+     */
+    template <class Writer>
+    void write_hot_transitions(Writer&& write, const char* alias, const char* const* state_names,
+                               const char* const* event_names, double coverage, size_t max = 16) const
+    {
+        hot_entry entries[64];
+        const size_t count = hottest(entries, max < 64 ? max : 64, coverage);
+
+        write("using ");
+        write(alias);
+        write(" = lib::hot_transitions<");
+        for (size_t i = 0; i < count; ++i)
+        {
+            char digits[24];
+            write(i == 0 ? "\n    lib::hot_transition<" : ",\n    lib::hot_transition<");
+            write(state_names[entries[i].state_id]);
+            write(", ");
+            write(event_names[entries[i].event_id]);
+            write("> /* ");
+            write(to_digits(entries[i].count, digits));
+            write(" */");
+        }
+        write(">;\n");
+    }
+
+private:
+    static bool listed(const hot_entry* entries, size_t count, size_t state_id, size_t event_id) noexcept
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (entries[i].state_id == state_id && entries[i].event_id == event_id)
+            {
+                return (true);
+            }
+        }
+        return (false);
+    }
+
+    static const char* to_digits(uint64_t value, char (&buffer)[24]) noexcept
+    {
+        char* it = buffer + sizeof(buffer) - 1;
+        *it      = '\0';
+        do
+        {
+            *--it = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        return (it);
+    }
+};
+}
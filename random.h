@@ -0,0 +1,63 @@
+#pragma once
+
+#include "type_traits.h"
+
+namespace lib
+{
+
+/** xorshift64* generator. Deterministic for a given seed and cheap enough for the dispatch path. */
+class xorshift
+{
+    uint64_t _state;
+
+public:
+    explicit constexpr xorshift(uint64_t seed) noexcept : _state(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+    uint64_t next(void) noexcept
+    {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return (_state * 0x2545F4914F6CDD1Dull);
+    }
+
+    /** Uniform in [0, bound). */
+    uint64_t below(uint64_t bound) noexcept { return (bound ? next() % bound : 0); }
+
+    /** Uniform in (0, 1]. */
+    double unit(void) noexcept { return (static_cast<double>((next() >> 11) + 1) * (1.0 / 9007199254740992.0)); }
+
+    /** Exponentially distributed with the given mean, i.e. Poisson arrivals. */
+    double exponential(double mean) noexcept { return (-mean * log(unit())); }
+
+    /** Natural logarithm for positive finite x; the library does not link libm. */
+    static double log(double x) noexcept
+    {
+        constexpr double LN2 = 0.69314718055994530942;
+
+        int exponent = 0;
+        while (x >= 2.0)
+        {
+            x *= 0.5;
+            ++exponent;
+        }
+        while (x < 1.0)
+        {
+            x *= 2.0;
+            --exponent;
+        }
+
+        // ln(x) = 2 * atanh((x - 1) / (x + 1)), |y| <= 1/3
+        const double y   = (x - 1.0) / (x + 1.0);
+        const double y2  = y * y;
+        double       sum = 0.0;
+        double       pow = y;
+        for (int n = 1; n < 30; n += 2)
+        {
+            sum += pow / n;
+            pow *= y2;
+        }
+        return (exponent * LN2 + 2.0 * sum);
+    }
+};
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "clock.h"
+#include "event_message.h"
+#include "random.h"
+#include "state_machine.h"
+#include "type_traits.h"
+
+namespace lib
+{
+
+/** Clock that only moves when the simulation advances it. */
+class virtual_clock : public iclock
+{
+    tick_t _now = 0;
+
+public:
+    tick_t now(void) const override { return (_now); }
+    void   advance_to(tick_t time) noexcept { _now = time > _now ? time : _now; }
+};
+
+/**
+ * Discrete-event simulation driver. Timestamped events and timers wait in a calendar queue of
+ * BUCKETS buckets WIDTH ticks wide, backed by a fixed pool of CAPACITY entries; run_until pops them
+ * in time order, advances the virtual clock and dispatches each one to its machine.
+ * Size BUCKETS near the number of pending entries and WIDTH near their mean spacing, so that
+ * each bucket holds a few entries.
+ * Entries with equal timestamps run in the order they were scheduled, so a run depends only on its
+ * inputs and the seed of random().
+ *
+ * Machine needs on_event(const ievent&). A timer is an ordinary event that a state schedules for
+ * clock().now() + delay.
+ */
+template <class Machine, size_t CAPACITY, size_t SIZE, size_t ALIGN = alignof(max_align_t), size_t BUCKETS = 1024,
+          tick_t WIDTH = 1>
+class simulation
+{
+public:
+    using message_type = message<SIZE, ALIGN>;
+
+    static_assert(BUCKETS > 0 && (BUCKETS & (BUCKETS - 1)) == 0, "BUCKETS must be a power of two");
+    static_assert(WIDTH > 0, "WIDTH must not be zero");
+
+private:
+    static constexpr size_t NPOS = ~size_t{0};
+
+    struct entry
+    {
+        tick_t                  time;
+        uint64_t                sequence;
+        Machine*                machine;
+        internal::_event_getter get;
+        size_t                  next;
+        message_type            data;
+    };
+
+    virtual_clock _clock;
+    xorshift      _random;
+    entry         _pool[CAPACITY];
+    size_t        _free = 0;
+    size_t        _buckets[BUCKETS];
+    size_t        _tails[BUCKETS];
+    size_t        _size     = 0;
+    uint64_t      _sequence = 0;
+    uint64_t      _executed = 0;
+
+public:
+    explicit simulation(uint64_t seed) noexcept : _random(seed)
+    {
+        for (size_t i = 0; i < CAPACITY; ++i)
+        {
+            _pool[i].next = i + 1 < CAPACITY ? i + 1 : NPOS;
+        }
+        for (size_t i = 0; i < BUCKETS; ++i)
+        {
+            _buckets[i] = NPOS;
+            _tails[i]   = NPOS;
+        }
+    }
+
+    simulation(const simulation&) = delete;
+    simulation& operator=(const simulation&) = delete;
+
+    const virtual_clock& clock(void) const noexcept { return (_clock); }
+    xorshift&            random(void) noexcept { return (_random); }
+    size_t               pending(void) const noexcept { return (_size); }
+    uint64_t             executed(void) const noexcept { return (_executed); }
+
+    /** Schedules event for machine at time, never earlier than now; returns false when the pool is exhausted. */
+    template <class Event>
+    bool schedule(tick_t time, Machine& machine, Event&& event)
+    {
+        using decayed = decay_t<Event>;
+        constexpr internal::_event_getter get = &internal::_erased_event<decayed>::get;
+
+        if (_free == NPOS)
+        {
+            return (false);
+        }
+        const size_t index = _free;
+        entry&       slot  = _pool[index];
+        _free              = slot.next;
+
+        slot.time     = time > _clock.now() ? time : _clock.now();
+        slot.sequence = _sequence++;
+        slot.machine  = &machine;
+        slot.get      = get;
+        slot.data     = forward<Event>(event);
+        insert(index);
+        ++_size;
+        return (true);
+    }
+
+    /** Dispatches every entry due at or before end, then leaves the clock at end. */
+    void run_until(tick_t end)
+    {
+        drain(end);
+        _clock.advance_to(end);
+    }
+
+    /** Dispatches until nothing is scheduled; the clock stays at the last entry. */
+    void run(void) { drain(~tick_t{0}); }
+
+private:
+    void drain(tick_t end)
+    {
+        size_t index;
+        while ((index = pop_due(end)) != NPOS)
+        {
+            entry& slot = _pool[index];
+            _clock.advance_to(slot.time);
+            slot.machine->on_event(slot.get(slot.data));
+            ++_executed;
+
+            slot.data.reset();
+            slot.next = _free;
+            _free     = index;
+        }
+    }
+
+    static size_t bucket_of(tick_t time) noexcept { return (static_cast<size_t>(time / WIDTH) & (BUCKETS - 1)); }
+
+    static bool before(const entry& lhs, const entry& rhs) noexcept
+    {
+        return (lhs.time < rhs.time || (lhs.time == rhs.time && lhs.sequence < rhs.sequence));
+    }
+
+    void insert(size_t index)
+    {
+        const size_t bucket = bucket_of(_pool[index].time);
+        _pool[index].next   = NPOS;
+        // Most entries are scheduled in time order and simply append.
+        if (_tails[bucket] == NPOS || !before(_pool[index], _pool[_tails[bucket]]))
+        {
+            (_tails[bucket] == NPOS ? _buckets[bucket] : _pool[_tails[bucket]].next) = index;
+            _tails[bucket]                                                           = index;
+            return;
+        }
+
+        size_t* link = &_buckets[bucket];
+        while (before(_pool[*link], _pool[index]))
+        {
+            link = &_pool[*link].next;
+        }
+        _pool[index].next = *link;
+        *link             = index;
+    }
+
+    /** Scans one calendar year from now; falls back to the global minimum when it is empty. */
+    size_t pop_due(tick_t end)
+    {
+        if (_size == 0)
+        {
+            return (NPOS);
+        }
+        const tick_t start = _clock.now() / WIDTH;
+        for (size_t i = 0; i < BUCKETS; ++i)
+        {
+            const tick_t day    = start + i;
+            size_t&      bucket = _buckets[static_cast<size_t>(day) & (BUCKETS - 1)];
+            if (bucket != NPOS && _pool[bucket].time / WIDTH == day)
+            {
+                return (_pool[bucket].time <= end ? unlink(bucket) : NPOS);
+            }
+            if (day > end / WIDTH)
+            {
+                return (NPOS);
+            }
+        }
+        size_t* const bucket = &_buckets[bucket_of(earliest())];
+        return (_pool[*bucket].time <= end ? unlink(*bucket) : NPOS);
+    }
+
+    size_t unlink(size_t& bucket) noexcept
+    {
+        const size_t index = bucket;
+        bucket             = _pool[index].next;
+        if (bucket == NPOS)
+        {
+            _tails[&bucket - _buckets] = NPOS;
+        }
+        --_size;
+        return (index);
+    }
+
+    tick_t earliest(void) const noexcept
+    {
+        tick_t time = ~tick_t{0};
+        for (const size_t bucket : _buckets)
+        {
+            if (bucket != NPOS && _pool[bucket].time < time)
+            {
+                time = _pool[bucket].time;
+            }
+        }
+        return (time);
+    }
+};
+}
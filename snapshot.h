@@ -0,0 +1,205 @@
+#pragma once
+
+#include "new.h"
+#include "type_traits.h"
+
+namespace lib
+{
+
+/**
+ * Copy-on-write storage for ITEMS instances of T.
+ * T must hold all of its state by value, since copying a page is all that separates two views.
+ * A compact_state_machine together with its lib::message data qualifies. A state_machine does not,
+ * because its copies share the same istate objects. Data kept inside istate objects is shared by
+ * every machine of the table either way, so keep per-machine data in T. None of this is checked:
+ * a T holding pointers or references to shared state compiles and silently shares it.
+ *
+ * A view is one version of all ITEMS. fork() shares every page of a view, so its cost is one page
+ * index per PAGE_ITEMS items; the first write() to a shared page copies just that page.
+ * discard() releases the pages nobody else shares. Pages come from a fixed arena of PAGES pages.
+ *
+ * Not synchronised: fork, write and discard views of one pool from a single thread.
+ */
+template <class T, size_t ITEMS, size_t PAGE_ITEMS, size_t PAGES>
+class cow_pool
+{
+public:
+    static_assert(ITEMS > 0 && PAGE_ITEMS > 0, "Empty pools are not supported");
+
+    static constexpr size_t PAGES_PER_VIEW = (ITEMS + PAGE_ITEMS - 1) / PAGE_ITEMS;
+
+    static_assert(PAGES >= PAGES_PER_VIEW, "The arena cannot hold a single view");
+
+    class view
+    {
+        friend class cow_pool;
+
+        size_t _pages[PAGES_PER_VIEW];
+        bool   _attached = false;
+
+    public:
+        view(void) noexcept = default;
+        view(const view&) = delete;
+        view& operator=(const view&) = delete;
+
+        bool attached(void) const noexcept { return (_attached); }
+    };
+
+private:
+    static constexpr size_t NPOS = ~size_t{0};
+
+    struct page
+    {
+        size_t refs  = 0;
+        size_t count = 0;    // Constructed items
+        size_t next  = NPOS; // Free list link
+        alignas(T) char storage[sizeof(T) * PAGE_ITEMS];
+
+        T*       items(void) noexcept { return (reinterpret_cast<T*>(storage)); }
+        const T* items(void) const noexcept { return (reinterpret_cast<const T*>(storage)); }
+    };
+
+    page   _arena[PAGES];
+    size_t _free       = 0;
+    size_t _free_count = PAGES;
+
+public:
+    cow_pool(void) noexcept
+    {
+        for (size_t i = 0; i < PAGES; ++i)
+        {
+            _arena[i].next = i + 1 < PAGES ? i + 1 : NPOS;
+        }
+    }
+
+    ~cow_pool(void) noexcept
+    {
+        for (page& target : _arena)
+        {
+            if (target.refs != 0)
+            {
+                destroy(target);
+            }
+        }
+    }
+
+    cow_pool(const cow_pool&) = delete;
+    cow_pool& operator=(const cow_pool&) = delete;
+
+    size_t free_pages(void) const noexcept { return (_free_count); }
+
+    /** Fills a detached view with copies of initial; returns false when the arena is short of pages. */
+    bool create(view& target, const T& initial)
+    {
+        if (target._attached || _free_count < PAGES_PER_VIEW)
+        {
+            return (false);
+        }
+        for (size_t p = 0; p < PAGES_PER_VIEW; ++p)
+        {
+            const size_t index = allocate();
+            page&        fresh = _arena[index];
+            for (; fresh.count < items_in(p); ++fresh.count)
+            {
+                ::new (&fresh.items()[fresh.count]) T(initial);
+            }
+            target._pages[p] = index;
+        }
+        target._attached = true;
+        return (true);
+    }
+
+    /** Makes a detached target share every page of source. */
+    bool fork(const view& source, view& target) noexcept
+    {
+        if (!source._attached || target._attached)
+        {
+            return (false);
+        }
+        for (size_t p = 0; p < PAGES_PER_VIEW; ++p)
+        {
+            target._pages[p] = source._pages[p];
+            ++_arena[source._pages[p]].refs;
+        }
+        target._attached = true;
+        return (true);
+    }
+
+    void discard(view& target) noexcept
+    {
+        if (!target._attached)
+        {
+            return;
+        }
+        for (size_t p = 0; p < PAGES_PER_VIEW; ++p)
+        {
+            release(target._pages[p]);
+        }
+        target._attached = false;
+    }
+
+    const T& read(const view& source, size_t index) const noexcept
+    {
+        return (_arena[source._pages[index / PAGE_ITEMS]].items()[index % PAGE_ITEMS]);
+    }
+
+    /** Gives write access to one item, copying its page first if it is shared; nullptr when out of pages. */
+    T* write(view& target, size_t index)
+    {
+        const size_t p      = index / PAGE_ITEMS;
+        size_t&      shared = target._pages[p];
+        if (_arena[shared].refs > 1)
+        {
+            if (_free_count == 0)
+            {
+                return (nullptr);
+            }
+            const size_t copy  = allocate();
+            page&        fresh = _arena[copy];
+            for (; fresh.count < _arena[shared].count; ++fresh.count)
+            {
+                ::new (&fresh.items()[fresh.count]) T(_arena[shared].items()[fresh.count]);
+            }
+            release(shared);
+            shared = copy;
+        }
+        return (&_arena[shared].items()[index % PAGE_ITEMS]);
+    }
+
+private:
+    static size_t items_in(size_t p) noexcept
+    {
+        return (p + 1 < PAGES_PER_VIEW ? PAGE_ITEMS : ITEMS - p * PAGE_ITEMS);
+    }
+
+    size_t allocate(void) noexcept
+    {
+        const size_t index = _free;
+        _free              = _arena[index].next;
+        _arena[index].refs = 1;
+        --_free_count;
+        return (index);
+    }
+
+    void release(size_t index) noexcept
+    {
+        page& target = _arena[index];
+        if (--target.refs != 0)
+        {
+            return;
+        }
+        destroy(target);
+        target.next = _free;
+        _free       = index;
+        ++_free_count;
+    }
+
+    static void destroy(page& target) noexcept
+    {
+        for (; target.count != 0; --target.count)
+        {
+            target.items()[target.count - 1].~T();
+        }
+    }
+};
+}
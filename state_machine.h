@@ -2,6 +2,14 @@
 
 #include "type_traits.h"
 
+#ifdef _MSC_VER
+#define LIB_COLD __declspec(noinline)
+#elif defined __GNUC__
+#define LIB_COLD __attribute__((noinline, cold))
+#else
+#define LIB_COLD
+#endif
+
 namespace lib
 {
 
@@ -21,22 +29,60 @@ struct event_base : ievent
     event_base(void) : ievent{ID} {}
 };
 
+/** Set of event IDs a state handles. IDs beyond BITS cannot be listed and are always accepted. */
+struct event_set
+{
+    static constexpr size_t BITS = 64;
+
+    uint64_t bits;
+
+    static constexpr event_set all(void) noexcept { return {~uint64_t{0}}; }
+
+    constexpr bool contains(event_id_t id) const noexcept { return (id >= BITS || ((bits >> id) & 1) != 0); }
+};
+
+namespace internal
+{
+template <class... Events>
+struct _event_bits : integral_constant<uint64_t, 0>
+{};
+
+template <class First, class... Events>
+struct _event_bits<First, Events...> :
+    integral_constant<uint64_t, (First::ID < event_set::BITS ? uint64_t{1} << First::ID : 0) |
+                                    _event_bits<Events...>::value>
+{};
+}
+
+/** Set of the IDs of Events, or of every event when Events is empty. */
+template <class... Events>
+constexpr event_set make_event_set(void) noexcept
+{
+    return (sizeof...(Events) == 0 ? event_set::all() : event_set{internal::_event_bits<Events...>::value});
+}
+
 struct istate
 {
     const state_id_t ID;
+    const state_id_t REDIRECT; // Differs from ID only for a pure redirect_state.
+    const event_set  ACCEPTS;  // Other events are dropped without calling on_event.
 
-    explicit istate(state_id_t id) : ID(id) {}
+    explicit istate(state_id_t id) : istate(id, id) {}
+    istate(state_id_t id, state_id_t redirect, event_set accepts = event_set::all()) :
+        ID(id), REDIRECT(redirect), ACCEPTS(accepts)
+    {}
     virtual ~istate(void) = default;
     virtual state_id_t on_enter(void) { return (ID); }
     virtual void       on_exit(void) {}
     virtual state_id_t on_event(const ievent& event) = 0;
 };
 
-template <state_id_t _ID>
+/** Events lists the event types the state handles; any other event is dropped before reaching it. */
+template <state_id_t _ID, class... Events>
 struct state_base : istate
 {
     static constexpr state_id_t ID = _ID;
-    state_base(void) : istate{ID} {}
+    state_base(void) : istate{ID, ID, make_event_set<Events...>()} {}
 
     state_id_t on_event(const ievent& event) override
     {
@@ -45,27 +91,290 @@ struct state_base : istate
     }
 };
 
+/**
+ * Routing state whose on_enter always redirects to _TARGET without side effects, and whose on_exit
+ * does nothing. Machines jump straight past it instead of calling into it.
+ */
+template <state_id_t _ID, state_id_t _TARGET>
+struct redirect_state final : istate
+{
+    static_assert(_ID != _TARGET, "A redirect must leave the state");
+
+    static constexpr state_id_t ID     = _ID;
+    static constexpr state_id_t TARGET = _TARGET;
+    redirect_state(void) : istate{ID, TARGET} {}
+
+    state_id_t on_enter(void) override { return (TARGET); }
+    state_id_t on_event(const ievent& event) override
+    {
+        (void)event;
+        return (TARGET);
+    }
+};
+
+struct dispatch_stats
+{
+    static constexpr size_t MAX_LENGTH = 7;
+
+    uint64_t lengths[MAX_LENGTH + 1]{}; // Redirect chain length per transition; the last bucket is MAX_LENGTH or more
+    uint64_t skipped = 0;               // Pure redirect states passed without being entered
+    uint64_t dropped = 0;               // Events rejected by ACCEPTS of the current state
+};
+
+/** Where the pure redirect chain starting at a state lands; see link_redirects. */
+struct redirect_link
+{
+    state_id_t landing; // The state itself when it is not a pure redirect
+    size_t     length;  // Pure redirect states in the chain, 0 when it is not one
+};
+
+/**
+ * Records in links[i] the first non-pure state that the redirect chain from states[i] lands on, so a
+ * transition skips the whole chain in one step. links is a table-level array of states_count entries,
+ * shared read-only by every machine on the table: fill it once during table setup, before any of
+ * them dispatches.
+ */
+inline void link_redirects(const istate* const* states, size_t states_count, redirect_link* links) noexcept
+{
+    for (size_t i = 0; i < states_count; ++i)
+    {
+        state_id_t landing = i;
+        size_t     length  = 0;
+        // A longer chain must be a cycle, which would never settle anyway.
+        while (states[landing]->REDIRECT != landing && length <= states_count)
+        {
+            landing = states[landing]->REDIRECT;
+            ++length;
+        }
+        links[i] = {landing, length};
+    }
+}
+
+/** Receives every (state, event) pair a machine dispatches; see transition_profile. */
+struct iprofile
+{
+    virtual ~iprofile(void) = default;
+    virtual void record(state_id_t state_id, event_id_t event_id) = 0;
+};
+
+namespace internal
+{
+/**
+ * Runs the exits and enters that follow on_event returning next_id, until the machine settles.
+ * Without links, pure redirect states are entered like any other.
+ */
+template <class Id>
+Id _transit(istate* const* states, const redirect_link* links, Id current_state_id, state_id_t next_id,
+            dispatch_stats* stats)
+{
+    size_t length  = 0;
+    size_t skipped = 0;
+    do
+    {
+        states[current_state_id]->on_exit();
+        if (links && links[next_id].length != 0)
+        {
+            length += links[next_id].length;
+            skipped += links[next_id].length;
+            next_id = links[next_id].landing;
+        }
+        current_state_id = static_cast<Id>(next_id);
+        next_id          = states[current_state_id]->on_enter();
+        length += next_id != current_state_id ? 1 : 0;
+    } while (next_id != current_state_id);
+
+    if (stats)
+    {
+        ++stats->lengths[length < dispatch_stats::MAX_LENGTH ? length : dispatch_stats::MAX_LENGTH];
+        stats->skipped += skipped;
+    }
+    return (current_state_id);
+}
+
+template <class Id>
+Id _dispatch(istate* const* states, const redirect_link* links, Id current_state_id, const ievent& event,
+             dispatch_stats* stats = nullptr, iprofile* profile = nullptr)
+{
+    if (profile)
+    {
+        profile->record(current_state_id, event.ID);
+    }
+
+    istate* const current = states[current_state_id];
+    if (!current->ACCEPTS.contains(event.ID))
+    {
+        if (stats)
+        {
+            ++stats->dropped;
+        }
+        return (current_state_id);
+    }
+
+    const state_id_t next_id = current->on_event(event);
+    return (next_id == current_state_id ? current_state_id
+                                        : _transit(states, links, current_state_id, next_id, stats));
+}
+
+template <class Id>
+LIB_COLD Id _cold_transit(istate* const* states, const redirect_link* links, Id current_state_id, state_id_t next_id,
+                          dispatch_stats* stats)
+{
+    return (_transit(states, links, current_state_id, next_id, stats));
+}
+}
+
+/**
+ * (state, event) pair that a specialised dispatcher tests before anything else and handles with a
+ * direct, inlinable call to State::on_event. State and Event are the concrete types.
+ * State must be the exact dynamic type of the table entry at State::ID: the dispatcher does
+ * static_cast<State*> and calls state->State::on_event, which bypasses any override in a more derived
+ * class. Declaring the state final rules that out.
+ */
+template <class State, class Event>
+struct hot_transition
+{};
+
+/** Hot pairs in the order they are tested, hottest first; usually generated by transition_profile. */
+template <class... Transitions>
+struct hot_transitions
+{};
+
+namespace internal
+{
+template <class Hot>
+struct _hot_dispatch;
+
+template <>
+struct _hot_dispatch<hot_transitions<>>
+{
+    template <class Id>
+    static bool dispatch(istate* const*, const redirect_link*, Id&, const ievent&, dispatch_stats*) noexcept
+    {
+        return (false);
+    }
+};
+
+template <class State, class Event, class... Rest>
+struct _hot_dispatch<hot_transitions<hot_transition<State, Event>, Rest...>>
+{
+    template <class Id>
+    static bool dispatch(istate* const* states, const redirect_link* links, Id& current_state_id, const ievent& event,
+                         dispatch_stats* stats)
+    {
+        if (current_state_id == State::ID && event.ID == Event::ID)
+        {
+            State* const state = static_cast<State*>(states[State::ID]);
+            if (state->ACCEPTS.contains(Event::ID))
+            {
+                const state_id_t next_id = state->State::on_event(event);
+                if (next_id != current_state_id)
+                {
+                    current_state_id = _cold_transit(states, links, current_state_id, next_id, stats);
+                }
+                return (true);
+            }
+        }
+        return (_hot_dispatch<hot_transitions<Rest...>>::dispatch(states, links, current_state_id, event, stats));
+    }
+};
+}
+
+/**
+ * links is optional: when given, it must have been filled by link_redirects for the same states before
+ * the machine dispatches, and the machine jumps straight past pure redirect chains.
+ */
 class state_machine
 {
-    istate** const   _states;
-    const state_id_t _states_count;
-    state_id_t       _current_state_id;
+    istate** const             _states;
+    const state_id_t           _states_count;
+    const redirect_link* const _links;
+    state_id_t                 _current_state_id;
+    dispatch_stats             _dispatch_stats;
+    iprofile*                  _profile = nullptr;
 
 public:
-    state_machine(istate** states, state_id_t states_count, state_id_t first_state_id) :
-        _states(states), _states_count(states_count), _current_state_id(first_state_id)
+    state_machine(istate** states, state_id_t states_count, state_id_t first_state_id,
+                  const redirect_link* links = nullptr) :
+        _states(states), _states_count(states_count), _links(links), _current_state_id(first_state_id)
     {}
 
+    state_id_t            current_state_id(void) const noexcept { return (_current_state_id); }
+    const dispatch_stats& get_dispatch_stats(void) const noexcept { return (_dispatch_stats); }
+
+    /** Records every dispatched (state, event) pair into profile until detached with nullptr. */
+    void attach_profile(iprofile* profile) noexcept { _profile = profile; }
+
+    /** Whether the current state handles the event; anything else would be dropped on dispatch. */
+    bool accepts(event_id_t id) const noexcept { return (_states[_current_state_id]->ACCEPTS.contains(id)); }
+
     void on_event(const ievent& event)
     {
-        (void)_states_count;
-        (void)event;
-        state_id_t next_id = _states[_current_state_id]->on_event(event);
-        while (next_id != _current_state_id)
+        _current_state_id =
+            internal::_dispatch(_states, _links, _current_state_id, event, &_dispatch_stats, _profile);
+    }
+};
+
+namespace internal
+{
+template <class Table, class = void>
+struct _table_links
+{
+    static const redirect_link* get(void) noexcept { return (nullptr); }
+};
+
+template <class Table>
+struct _table_links<Table, void_t<decltype(Table::links())>>
+{
+    static const redirect_link* get(void) noexcept { return (Table::links()); }
+};
+}
+
+/**
+ * State machine whose state table is shared by every instance through Table:
+ *
+ *     struct table
+ *     {
+ *         static constexpr state_id_t COUNT = 3;
+ *         static istate* const*       states(void);
+ *         static const redirect_link* links(void); // Optional
+ *     };
+ *
+ * The only per-instance data is the current state ID, held in the smallest type that fits COUNT.
+ * To collapse redirect chains, fill the array returned by links() with link_redirects once, before
+ * any machine on the table dispatches.
+ * Hot lists the transitions to test first; transitions are still run out of line.
+ */
+template <class Table, class Hot = hot_transitions<>>
+class compact_state_machine
+{
+public:
+    static_assert(Table::COUNT > 0, "A machine needs at least one state");
+
+    using id_type = smallest_uint_t<Table::COUNT - 1>;
+
+private:
+    id_type _current_state_id;
+
+public:
+    explicit compact_state_machine(state_id_t first_state_id) noexcept :
+        _current_state_id(static_cast<id_type>(first_state_id))
+    {}
+
+    state_id_t current_state_id(void) const noexcept { return (_current_state_id); }
+
+    bool accepts(event_id_t id) const noexcept { return (Table::states()[_current_state_id]->ACCEPTS.contains(id)); }
+
+    /** stats and profile are optional, since the machine keeps no counters of its own. */
+    void on_event(const ievent& event, dispatch_stats* stats = nullptr, iprofile* profile = nullptr)
+    {
+        if (profile)
+        {
+            profile->record(_current_state_id, event.ID);
+        }
+        const redirect_link* const links = internal::_table_links<Table>::get();
+        if (!internal::_hot_dispatch<Hot>::dispatch(Table::states(), links, _current_state_id, event, stats))
         {
-            _states[_current_state_id]->on_exit();
-            _current_state_id = next_id;
-            next_id           = _states[_current_state_id]->on_enter();
+            _current_state_id = internal::_dispatch(Table::states(), links, _current_state_id, event, stats);
         }
     }
 };
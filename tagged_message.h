@@ -0,0 +1,290 @@
+#pragma once
+
+#include "mail_sender.h"
+#include "new.h"
+#include "type_traits.h"
+
+namespace lib
+{
+
+namespace internal
+{
+template <class T, class... Types>
+struct _index_of;
+
+template <class T, class... Types>
+struct _index_of<T, T, Types...> : integral_constant<size_t, 0>
+{};
+
+template <class T, class First, class... Types>
+struct _index_of<T, First, Types...> : integral_constant<size_t, 1 + _index_of<T, Types...>::value>
+{};
+
+template <class T>
+struct _index_of<T>
+{
+    static_assert(sizeof(T) == 0, "Type is not registered");
+};
+}
+
+/**
+ * Compile-time numbering of payload types. Tag 0 means empty and Types[i] is tag i + 1,
+ * so a tag is only meaningful against the same registry. Tags read back from outside the process
+ * may be corrupt: vtable and visit check them against COUNT before indexing.
+ */
+template <class... Types>
+struct message_registry
+{
+    static_assert(sizeof...(Types) > 0, "At least one type is required");
+
+    static constexpr size_t COUNT   = sizeof...(Types);
+    static constexpr size_t SIZE    = largest<Types...>::SIZE;
+    static constexpr size_t ALIGN   = largest<Types...>::ALIGN;
+    static constexpr bool   TRIVIAL = conjunction<is_trivially_copyable<Types>...>::value;
+
+    using tag_type = smallest_uint_t<COUNT>;
+
+    template <class T>
+    static constexpr tag_type tag_of(void) noexcept
+    {
+        return (static_cast<tag_type>(internal::_index_of<remove_cv_t<T>, Types...>::value + 1));
+    }
+
+    /** Whether tag is empty or names one of Types. */
+    static constexpr bool valid(size_t tag) noexcept { return (tag <= COUNT); }
+
+    /** nullptr for the empty tag and for invalid tags. */
+    static const internal::_vtable_format* vtable(tag_type tag) noexcept
+    {
+        static const internal::_vtable_format* const vtables[] = {nullptr, internal::get_cached_vtable<Types>()...};
+        return (valid(tag) ? vtables[tag] : nullptr);
+    }
+
+    /** Returns false without calling visitor when tag is empty or invalid. */
+    template <class Visitor>
+    static bool visit(tag_type tag, void* data, Visitor& visitor)
+    {
+        using thunk = void (*)(void*, Visitor&);
+
+        static constexpr thunk thunks[] = {&visit_thunk<Types, Visitor>...};
+        if (tag == 0 || !valid(tag))
+        {
+            return (false);
+        }
+        thunks[tag - 1](data, visitor);
+        return (true);
+    }
+
+    template <class Visitor>
+    static bool visit(tag_type tag, const void* data, Visitor& visitor)
+    {
+        using thunk = void (*)(const void*, Visitor&);
+
+        static constexpr thunk thunks[] = {&visit_thunk<const Types, Visitor>...};
+        if (tag == 0 || !valid(tag))
+        {
+            return (false);
+        }
+        thunks[tag - 1](data, visitor);
+        return (true);
+    }
+
+private:
+    template <class T, class Visitor>
+    static void visit_thunk(void* data, Visitor& visitor)
+    {
+        visitor(*static_cast<T*>(data));
+    }
+
+    template <class T, class Visitor>
+    static void visit_thunk(const void* data, Visitor& visitor)
+    {
+        visitor(*static_cast<T*>(data));
+    }
+};
+
+namespace internal
+{
+template <class Registry>
+class _tagged_storage
+{
+public:
+    using tag_type = typename Registry::tag_type;
+
+protected:
+    alignas(Registry::ALIGN) char _buffer[Registry::SIZE];
+    tag_type                      _tag = 0;
+
+public:
+    bool     has_value(void) const noexcept { return (_tag != 0); }
+    tag_type tag(void) const noexcept { return (_tag); }
+
+    /** False when the tag, e.g. of a message read back from a journal, names no registered type. */
+    bool valid(void) const noexcept { return (Registry::valid(_tag)); }
+
+    template <class T>
+    bool holds(void) const noexcept
+    {
+        return (_tag == Registry::template tag_of<T>());
+    }
+
+    template <class T>
+    T* get_if(void) noexcept
+    {
+        return (holds<T>() ? reinterpret_cast<T*>(_buffer) : nullptr);
+    }
+
+    template <class T>
+    const T* get_if(void) const noexcept
+    {
+        return (holds<T>() ? reinterpret_cast<const T*>(_buffer) : nullptr);
+    }
+
+    template <class Visitor>
+    bool _visit(Visitor& visitor)
+    {
+        return (Registry::visit(_tag, static_cast<void*>(_buffer), visitor));
+    }
+
+    template <class Visitor>
+    bool _visit(Visitor& visitor) const
+    {
+        return (Registry::visit(_tag, static_cast<const void*>(_buffer), visitor));
+    }
+
+protected:
+    // An invalid tag is treated as empty: nothing is destroyed, copied or moved.
+    void destroy(void) noexcept
+    {
+        const internal::_vtable_format* const vtable = Registry::TRIVIAL ? nullptr : Registry::vtable(_tag);
+        if (vtable)
+        {
+            vtable->destroy(_buffer);
+        }
+        _tag = 0;
+    }
+
+    void copy_from(const _tagged_storage& rhs)
+    {
+        destroy();
+        const internal::_vtable_format* const vtable = Registry::vtable(rhs._tag);
+        if (vtable)
+        {
+            vtable->copy_assign(rhs._buffer, _buffer);
+            _tag = rhs._tag;
+        }
+    }
+
+    void move_from(_tagged_storage&& rhs)
+    {
+        destroy();
+        const internal::_vtable_format* const vtable = Registry::vtable(rhs._tag);
+        if (vtable)
+        {
+            vtable->move_assign(rhs._buffer, _buffer);
+            _tag = rhs._tag;
+            rhs.destroy();
+        }
+    }
+
+    template <class Decayed, class... Args>
+    Decayed& _emplace(Args&&... args)
+    {
+        destroy();
+        new (_buffer) Decayed{forward<Args>(args)...};
+        _tag = Registry::template tag_of<Decayed>();
+        return (*reinterpret_cast<Decayed*>(_buffer));
+    }
+};
+}
+
+/**
+ * Message that identifies its payload by a 1-2 byte registry tag instead of a vtable pointer.
+ * When every registered type is trivially copyable, so is the message: it can be memcpy'd,
+ * written to shared memory or a journal and read back as-is by any process using the same registry.
+ */
+template <class Registry, bool = Registry::TRIVIAL>
+class tagged_message : public internal::_tagged_storage<Registry>
+{
+    using base = internal::_tagged_storage<Registry>;
+
+public:
+    tagged_message(void) noexcept = default;
+
+    template <class T, disable_if_t<is_same<tagged_message, decay_t<T>>::value>* = nullptr>
+    explicit tagged_message(T&& data)
+    {
+        base::template _emplace<decay_t<T>>(forward<T>(data));
+    }
+
+    template <class T, class... Args>
+    decay_t<T>& emplace(Args&&... args)
+    {
+        return (base::template _emplace<decay_t<T>>(forward<Args>(args)...));
+    }
+
+    void reset(void) noexcept { base::destroy(); }
+};
+
+template <class Registry>
+class tagged_message<Registry, false> : public internal::_tagged_storage<Registry>
+{
+    using base = internal::_tagged_storage<Registry>;
+
+public:
+    tagged_message(void) noexcept = default;
+
+    tagged_message(const tagged_message& rhs) { base::copy_from(rhs); }
+
+    tagged_message(tagged_message&& rhs) noexcept { base::move_from(move(rhs)); }
+
+    template <class T, disable_if_t<is_same<tagged_message, decay_t<T>>::value>* = nullptr>
+    explicit tagged_message(T&& data)
+    {
+        base::template _emplace<decay_t<T>>(forward<T>(data));
+    }
+
+    ~tagged_message(void) noexcept { base::destroy(); }
+
+    tagged_message& operator=(const tagged_message& rhs)
+    {
+        if (this != &rhs)
+        {
+            base::copy_from(rhs);
+        }
+        return (*this);
+    }
+
+    tagged_message& operator=(tagged_message&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            base::move_from(move(rhs));
+        }
+        return (*this);
+    }
+
+    template <class T, class... Args>
+    decay_t<T>& emplace(Args&&... args)
+    {
+        return (base::template _emplace<decay_t<T>>(forward<Args>(args)...));
+    }
+
+    void reset(void) noexcept { base::destroy(); }
+};
+
+/** Calls visitor with the payload through the registry's jump table. Returns false when empty or invalid. */
+template <class Registry, bool TRIVIAL, class Visitor>
+bool visit(tagged_message<Registry, TRIVIAL>& target, Visitor&& visitor)
+{
+    return (target._visit(visitor));
+}
+
+template <class Registry, bool TRIVIAL, class Visitor>
+bool visit(const tagged_message<Registry, TRIVIAL>& target, Visitor&& visitor)
+{
+    return (target._visit(visitor));
+}
+
+using mail_registry = message_registry<morning_greeting, evening_greeting, afternoon_greeting, night_greeting>;
+}
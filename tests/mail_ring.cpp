@@ -0,0 +1,158 @@
+// mail_ring reserve/peek across the wrap, partial reserves, and the mail_exchange wake handshake between
+// two processes sharing an anonymous mapping: the child sleeps on the futex whenever its rings run dry,
+// the parent sends in bursts with pauses in between. A lost wake-up leaves the child asleep until the
+// alarm kills it. Exits non-zero on any failure.
+//
+//     g++ -std=c++11 -Wall -Wextra -pthread -I.. mail_ring.cpp && ./a.out
+
+#include "mail_ring_linux.h"
+#include "new.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+int failures = 0;
+
+void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+mail numbered(int index)
+{
+    mail result{};
+    result.header         = {mail_address::A, mail_address::B, mail_subject::morning};
+    result.body.morning.m = index;
+    return (result);
+}
+
+void wrap_around(void)
+{
+    static lib::mail_ring<8> ring;
+    mail*                    first = nullptr;
+    const mail*              read  = nullptr;
+
+    check(ring.reserve(first, 6) == 6, "an empty ring reserves what was asked");
+    mail* const start = first;
+    ring.commit(6);
+    check(ring.peek(read, 8) == 6, "peek sees every committed slot");
+    ring.release(6);
+
+    check(ring.reserve(first, 5) == 2 && first == start + 6, "a reserve stops at the end of the slots");
+    first[0] = numbered(0);
+    first[1] = numbered(1);
+    ring.commit(2);
+    check(ring.reserve(first, 3) == 3 && first == start, "the next reserve starts over at the first slot");
+    for (int i = 0; i < 3; ++i)
+    {
+        first[i] = numbered(2 + i);
+    }
+    ring.commit(3);
+    check(ring.reserve(first, 8) == 3, "a reserve is cut to the free slots");
+
+    int expected = 0;
+    for (lib::size_t ready; (ready = ring.peek(read, 8)) != 0; ring.release(ready))
+    {
+        for (lib::size_t i = 0; i < ready; ++i)
+        {
+            check(read[i].body.morning.m == expected++, "mails come out in order across the wrap");
+        }
+    }
+    check(expected == 5 && ring.empty(), "every committed mail was read");
+
+    check(ring.reserve(first, 8) == 5 && first == start + 3, "a drained ring reserves up to the end of the slots");
+    ring.commit(5);
+    check(ring.reserve(first, 8) == 3 && first == start, "the rest of a drained ring follows the wrap");
+    ring.commit(3);
+    check(ring.reserve(first, 1) == 0, "a full ring reserves nothing");
+}
+
+constexpr int BURSTS     = 200;
+constexpr int BURST_SIZE = 300; // Above CAPACITY, so bursts also wait for room.
+
+using exchange_type = lib::mail_exchange<256>;
+
+int receive_all(exchange_type& exchange)
+{
+    alarm(20);
+    mail out[64];
+    int  expected = 0;
+    bool ordered  = true;
+    while (expected < BURSTS * BURST_SIZE)
+    {
+        const lib::size_t received = exchange.receive(mail_address::B, out, 64);
+        if (received == 0)
+        {
+            lib::wait_for_mail(exchange, mail_address::B);
+            continue;
+        }
+        for (lib::size_t i = 0; i < received; ++i)
+        {
+            ordered = ordered && out[i].header.from == mail_address::A && out[i].body.morning.m == expected;
+            ++expected;
+        }
+    }
+    return (ordered ? 0 : 1);
+}
+
+void wake_handshake(void)
+{
+    void* const memory =
+        mmap(nullptr, sizeof(exchange_type), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        check(false, "mmap");
+        return;
+    }
+    exchange_type* const exchange = ::new (memory) exchange_type;
+
+    const pid_t child = fork();
+    if (child == 0)
+    {
+        _exit(receive_all(*exchange));
+    }
+
+    mail batch[BURST_SIZE];
+    int  next = 0;
+    for (int burst = 0; burst < BURSTS; ++burst)
+    {
+        for (mail& target : batch)
+        {
+            target = numbered(next++);
+        }
+        for (lib::size_t sent = 0; sent < BURST_SIZE;)
+        {
+            sent += lib::send_mails(*exchange, mail_address::A, mail_address::B, batch + sent, BURST_SIZE - sent);
+        }
+        // Give the receiver time to drain the rings and go to sleep.
+        if (burst % 4 == 0)
+        {
+            usleep(200);
+        }
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "the receiver got every mail in order");
+    check(!WIFSIGNALED(status), "the receiver was woken after every burst");
+    exchange->~exchange_type();
+    munmap(memory, sizeof(exchange_type));
+}
+}
+
+int main(void)
+{
+    wrap_around();
+    wake_handshake();
+    printf("mail_ring %s\n", failures == 0 ? "ok" : "FAILED");
+    return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,153 @@
+// Round-trips mails through a unix socketpair and through a pipe. A writer thread sends them with
+// write_mails; the reader drains them with mail_stream_poller into a mailbox smaller than the stream,
+// so decoding regularly stalls on a full mailbox and a full decoder buffer. Exits non-zero on any mismatch.
+//
+//     g++ -std=c++11 -Wall -Wextra -pthread -I.. mail_stream.cpp && ./a.out
+
+#include "mail_stream_linux.h"
+#include "mailbox.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+// Several times a socket or pipe buffer, so the writer has to wait for room.
+constexpr lib::size_t MAIL_COUNT = 20000;
+
+using mailbox_type = lib::mailbox<sizeof(mail), alignof(mail), 64>;
+using poller_type  = lib::mail_stream_poller<128, 4>;
+
+mail sent[MAIL_COUNT];
+
+void fill(mail& target, lib::size_t index)
+{
+    const mail_address from    = index % 2 ? mail_address::A : mail_address::C;
+    const mail_subject subject = static_cast<mail_subject>(index % mail_subject_count);
+    target.header              = {from, mail_address::B, subject};
+    switch (subject)
+    {
+    case mail_subject::morning:
+        target.body.morning.m = static_cast<int>(index);
+        break;
+    case mail_subject::evening:
+        target.body.evening.message[0] = static_cast<char>(index);
+        break;
+    case mail_subject::afternoon:
+        target.body.afternoon.param[3] = index;
+        break;
+    case mail_subject::night:
+        target.body.night.option[7] = static_cast<short>(index);
+        break;
+    }
+}
+
+bool same(const mail& lhs, const mail& rhs)
+{
+    if (lhs.header.from != rhs.header.from || lhs.header.to != rhs.header.to ||
+        lhs.header.subject != rhs.header.subject)
+    {
+        return (false);
+    }
+    // Only the body member named by the subject is on the wire.
+    const char* const lhs_body = reinterpret_cast<const char*>(&lhs.body);
+    const char* const rhs_body = reinterpret_cast<const char*>(&rhs.body);
+    for (lib::size_t i = 0; i < lib::mail_body_size(lhs.header.subject); ++i)
+    {
+        if (lhs_body[i] != rhs_body[i])
+        {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+struct writer
+{
+    int  fd;
+    bool ok;
+};
+
+void* write_stream(void* argument)
+{
+    writer& target = *static_cast<writer*>(argument);
+    target.ok      = lib::write_mails(target.fd, sent, MAIL_COUNT);
+    close(target.fd);
+    return (nullptr);
+}
+
+bool run_case(const char* name, int read_fd, int write_fd)
+{
+    fcntl(read_fd, F_SETFL, O_NONBLOCK);
+    fcntl(write_fd, F_SETFL, O_NONBLOCK);
+
+    static mailbox_type inbox;
+    poller_type         poller;
+    const lib::size_t   index = poller.add(read_fd);
+    if (!poller.valid() || index == poller_type::NPOS)
+    {
+        return (false);
+    }
+
+    writer    output{write_fd, false};
+    pthread_t thread;
+    pthread_create(&thread, nullptr, &write_stream, &output);
+
+    lib::size_t                frames   = 0;
+    lib::size_t                received = 0;
+    lib::size_t                failures = 0;
+    mailbox_type::message_type out;
+    lib::size_t                key = 0;
+    auto route = [](const mail_header& header) -> mailbox_type* {
+        return (header.to == mail_address::B ? &inbox : nullptr);
+    };
+    while (received < MAIL_COUNT)
+    {
+        const lib::size_t decoded = poller.poll(route, 1000);
+        frames += decoded;
+        // Take only part of the mailbox, so the next poll still finds it partly full.
+        for (lib::size_t i = 0; i < 16 && inbox.fetch(out, &key); ++i, ++received)
+        {
+            const mail* got = lib::any_cast<mail>(&out);
+            if (!got || key != static_cast<lib::size_t>(sent[received].header.subject) || !same(*got, sent[received]))
+            {
+                ++failures;
+            }
+        }
+        // Closed and nothing left to decode: whatever is missing never arrived.
+        if (decoded == 0 && !poller.open(index) && inbox.empty())
+        {
+            break;
+        }
+    }
+    pthread_join(thread, nullptr);
+    close(read_fd);
+
+    const bool passed = output.ok && frames == MAIL_COUNT && received == MAIL_COUNT && failures == 0 &&
+                        !poller.corrupt(index) && !poller.open(index);
+    printf("%-10s frames %zu received %zu failures %zu %s\n", name, frames, received, failures,
+           passed ? "ok" : "FAILED");
+    return (passed);
+}
+}
+
+int main(void)
+{
+    for (lib::size_t i = 0; i < MAIL_COUNT; ++i)
+    {
+        fill(sent[i], i);
+    }
+
+    bool passed = true;
+
+    int pair[2];
+    passed = socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0 && run_case("socketpair", pair[0], pair[1]) && passed;
+
+    int pipe_ends[2];
+    passed = pipe(pipe_ends) == 0 && run_case("pipe", pipe_ends[0], pipe_ends[1]) && passed;
+
+    return (passed ? 0 : 1);
+}
@@ -0,0 +1,186 @@
+// Behaviour of lib::mailbox: per-lane FIFO under concurrent producers, lane priority, coalescing,
+// full lanes and out-of-range keys. Exits non-zero on any failure; run it under -fsanitize=thread too.
+//
+//     g++ -std=c++11 -Wall -Wextra -pthread -I.. mailbox.cpp && ./a.out
+
+#include "mailbox.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+namespace
+{
+struct item
+{
+    lib::size_t producer;
+    lib::size_t sequence;
+};
+
+int failures = 0;
+
+void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+const item* fetch(lib::internal::_message& out)
+{
+    return (lib::any_cast<item>(&out));
+}
+
+// Two lanes with two keys each; 0 and 1 go to lane 0, 2 and 3 to lane 1.
+using stress_mailbox = lib::mailbox<sizeof(item), alignof(item), 64, 2, 4>;
+
+constexpr lib::size_t PRODUCERS = 4;
+constexpr lib::size_t PER_KEY   = 20000;
+constexpr lib::size_t KEYS      = 4;
+
+stress_mailbox stress;
+
+void* produce(void* argument)
+{
+    const lib::size_t producer = *static_cast<const lib::size_t*>(argument);
+    for (lib::size_t sequence = 0; sequence < PER_KEY; ++sequence)
+    {
+        for (lib::size_t key = 0; key < KEYS; ++key)
+        {
+            // Yield on a full lane, so the consumer gets to run even on a single core.
+            while (!stress.post(key, item{producer, sequence}))
+            {
+                sched_yield();
+            }
+        }
+    }
+    return (nullptr);
+}
+
+void multi_producer_fifo(void)
+{
+    for (lib::size_t key = 0; key < KEYS; ++key)
+    {
+        stress.set_policy(key, {key / 2, false});
+    }
+
+    lib::size_t ids[PRODUCERS];
+    pthread_t   threads[PRODUCERS];
+    for (lib::size_t i = 0; i < PRODUCERS; ++i)
+    {
+        ids[i] = i;
+        pthread_create(&threads[i], nullptr, &produce, &ids[i]);
+    }
+
+    lib::size_t                  next[PRODUCERS][KEYS]{};
+    lib::size_t                  received = 0;
+    bool                         ordered  = true;
+    stress_mailbox::message_type out;
+    lib::size_t                  key = 0;
+    while (received < PRODUCERS * KEYS * PER_KEY)
+    {
+        if (!stress.fetch(out, &key))
+        {
+            sched_yield();
+            continue;
+        }
+        const item* got = fetch(out);
+        if (!got || key >= KEYS || got->producer >= PRODUCERS || got->sequence != next[got->producer][key]++)
+        {
+            ordered = false;
+        }
+        ++received;
+    }
+    for (pthread_t thread : threads)
+    {
+        pthread_join(thread, nullptr);
+    }
+    check(ordered, "every producer's posts to a key arrive once and in order");
+    check(stress.empty(), "nothing is left once every post was fetched");
+}
+
+using small_mailbox = lib::mailbox<sizeof(item), alignof(item), 8, 2, 4>;
+
+void lane_priority(void)
+{
+    static small_mailbox box;
+    box.set_policy(0, {0, false});
+    box.set_policy(1, {1, false});
+
+    box.post(1, item{0, 1});
+    box.post(1, item{0, 2});
+    box.post(0, item{0, 3});
+
+    small_mailbox::message_type out;
+    lib::size_t                 key = 0;
+    check(box.fetch(out, &key) && key == 0 && fetch(out)->sequence == 3, "lane 0 is served before lane 1");
+    check(box.fetch(out, &key) && key == 1 && fetch(out)->sequence == 1, "lane 1 is FIFO");
+    check(box.fetch(out, &key) && key == 1 && fetch(out)->sequence == 2, "lane 1 is FIFO");
+    check(!box.fetch(out, &key), "the mailbox is empty");
+}
+
+void coalescing(void)
+{
+    static small_mailbox box;
+    box.set_policy(2, {0, true});
+
+    box.post(2, item{0, 1});
+    box.post(0, item{0, 100});
+    box.post(2, item{0, 2});
+    box.post(2, item{0, 3});
+
+    small_mailbox::message_type out;
+    lib::size_t                 key = 0;
+    check(box.fetch(out, &key) && key == 2 && fetch(out)->sequence == 3, "the queued post holds the latest value");
+    check(box.fetch(out, &key) && key == 0 && fetch(out)->sequence == 100, "coalescing keeps its queue position");
+    check(!box.fetch(out, &key), "coalesced posts take one slot");
+
+    box.post(2, item{0, 4});
+    box.post(2, item{0, 5});
+    check(box.fetch(out, &key) && key == 2 && fetch(out)->sequence == 5, "coalescing restarts after a fetch");
+    check(!box.fetch(out, &key), "the restarted post took one slot");
+}
+
+void full_lane(void)
+{
+    static small_mailbox box;
+    box.set_policy(0, {0, false});
+    box.set_policy(3, {1, false});
+
+    bool accepted = true;
+    for (lib::size_t i = 0; i < 8; ++i)
+    {
+        accepted = box.post(0, item{0, i}) && accepted;
+    }
+    check(accepted, "a lane takes CAPACITY posts");
+    check(!box.post(0, item{0, 8}), "a full lane rejects the next post");
+    check(box.post(3, item{0, 9}), "other lanes still take posts");
+
+    small_mailbox::message_type out;
+    lib::size_t                 key = 0;
+    check(box.fetch(out, &key) && fetch(out)->sequence == 0, "the first post is fetched first");
+    check(box.post(0, item{0, 10}), "a fetch frees a slot");
+}
+
+void key_range(void)
+{
+    static small_mailbox box;
+    check(!box.set_policy(4, {0, true}), "set_policy rejects a key >= KEYS");
+    check(!box.post(4, item{0, 0}), "post rejects a key >= KEYS");
+    check(!box.post_emplace<item>(~lib::size_t{0}, [](item&) {}), "post_emplace rejects a key >= KEYS");
+    check(box.empty(), "rejected posts leave nothing behind");
+}
+}
+
+int main(void)
+{
+    multi_producer_fifo();
+    lane_priority();
+    coalescing();
+    full_lane();
+    key_range();
+    printf("mailbox %s\n", failures == 0 ? "ok" : "FAILED");
+    return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,163 @@
+// lib::simulation against a reference queue that sorts by (time, schedule order) with a linear scan.
+// A seeded schedule puts many events on equal timestamps and spreads the rest over several calendar
+// years; handling an event may schedule another from inside on_event, with no delay, a short one, or a
+// time already in the past. Both sides must dispatch the same events in the same order at the same
+// times. Exits non-zero on any mismatch.
+//
+//     g++ -std=c++11 -Wall -Wextra -pthread -I.. simulation.cpp && ./a.out
+
+#include "simulation.h"
+
+#include <stdio.h>
+
+namespace
+{
+constexpr lib::size_t INITIAL = 3000;
+constexpr lib::size_t LIMIT   = 6000; // Initial and follow-up events together
+constexpr lib::size_t HALT    = 400;  // run_until stops here before run finishes
+
+struct numbered : lib::event_base<0>
+{
+    lib::size_t id;
+    explicit numbered(lib::size_t number) : id(number) {}
+};
+
+// Whether handling id schedules another event, and when, relative to now. Shared by both sides.
+bool follows(lib::size_t id) noexcept
+{
+    return (id % 3 == 0);
+}
+
+lib::tick_t follow_time(lib::size_t id, lib::tick_t now) noexcept
+{
+    const lib::size_t choice = id % 4;
+    return (choice == 0 ? now : choice == 3 && now > 5 ? now - 5 : now + choice * 7);
+}
+
+struct dispatch
+{
+    lib::size_t id;
+    lib::tick_t time;
+};
+
+struct machine;
+
+// 8 buckets 16 ticks wide: a calendar year is 128 ticks, well short of the schedule.
+using simulation_type = lib::simulation<machine, LIMIT, sizeof(numbered), alignof(numbered), 8, 16>;
+
+struct machine
+{
+    simulation_type& simulation;
+    dispatch*        log;
+    lib::size_t      count   = 0;
+    lib::size_t      next_id = INITIAL;
+
+    machine(simulation_type& owner, dispatch* entries) : simulation(owner), log(entries) {}
+
+    void on_event(const lib::ievent& event)
+    {
+        const lib::size_t id = static_cast<const numbered&>(event).id;
+        log[count++]         = {id, simulation.clock().now()};
+        if (follows(id) && next_id < LIMIT)
+        {
+            simulation.schedule(follow_time(id, simulation.clock().now()), *this, numbered{next_id++});
+        }
+    }
+};
+
+struct reference
+{
+    struct pending
+    {
+        lib::tick_t time;
+        lib::size_t sequence;
+        lib::size_t id;
+    };
+
+    pending     queue[LIMIT];
+    lib::size_t size     = 0;
+    lib::size_t sequence = 0;
+    lib::tick_t now      = 0;
+    lib::size_t next_id  = INITIAL;
+
+    void schedule(lib::tick_t time, lib::size_t id) { queue[size++] = {time > now ? time : now, sequence++, id}; }
+
+    lib::size_t run(dispatch* log)
+    {
+        lib::size_t count = 0;
+        while (size != 0)
+        {
+            lib::size_t first = 0;
+            for (lib::size_t i = 1; i < size; ++i)
+            {
+                const pending& lhs = queue[i];
+                const pending& rhs = queue[first];
+                if (lhs.time < rhs.time || (lhs.time == rhs.time && lhs.sequence < rhs.sequence))
+                {
+                    first = i;
+                }
+            }
+            const pending due = queue[first];
+            queue[first]      = queue[--size];
+            now               = due.time;
+            log[count++]      = {due.id, now};
+            if (follows(due.id) && next_id < LIMIT)
+            {
+                schedule(follow_time(due.id, now), next_id++);
+            }
+        }
+        return (count);
+    }
+};
+
+dispatch        actual[LIMIT];
+dispatch        expected[LIMIT];
+reference       model;
+simulation_type simulated(42);
+}
+
+int main(void)
+{
+    machine target{simulated, actual};
+    for (lib::size_t id = 0; id < INITIAL; ++id)
+    {
+        // Half the events share 64 timestamps; the rest spread over eight calendar years.
+        const lib::tick_t time = simulated.random().below(2) ? simulated.random().below(64) * 16
+                                                               : simulated.random().below(1024);
+        simulated.schedule(time, target, numbered{id});
+        model.schedule(time, id);
+    }
+
+    simulated.run_until(HALT);
+    const bool halted = simulated.clock().now() == HALT;
+    for (lib::size_t i = 0; i < target.count; ++i)
+    {
+        if (actual[i].time > HALT)
+        {
+            printf("FAILED: run_until(%llu) dispatched an event due at %llu\n",
+                   static_cast<unsigned long long>(HALT), static_cast<unsigned long long>(actual[i].time));
+            return (1);
+        }
+    }
+    simulated.run();
+
+    const lib::size_t count      = model.run(expected);
+    lib::size_t       mismatches = 0;
+    for (lib::size_t i = 0; i < count && i < target.count; ++i)
+    {
+        if (actual[i].id != expected[i].id || actual[i].time != expected[i].time)
+        {
+            if (mismatches++ == 0)
+            {
+                printf("FAILED: dispatch %zu was event %zu at %llu, expected event %zu at %llu\n", i, actual[i].id,
+                       static_cast<unsigned long long>(actual[i].time), expected[i].id,
+                       static_cast<unsigned long long>(expected[i].time));
+            }
+        }
+    }
+
+    const bool passed = halted && count > INITIAL && target.count == count && mismatches == 0 &&
+                        simulated.pending() == 0 && simulated.executed() == count;
+    printf("simulation %zu events %s\n", target.count, passed ? "ok" : "FAILED");
+    return (passed ? 0 : 1);
+}
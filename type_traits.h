@@ -25,6 +25,15 @@ using uintptr_t = unsigned long;
 
 using nullptr_t = decltype(nullptr);
 
+using int8_t   = signed char;
+using int16_t  = short;
+using int32_t  = int;
+using int64_t  = long long;
+using uint8_t  = unsigned char;
+using uint16_t = unsigned short;
+using uint32_t = unsigned int;
+using uint64_t = unsigned long long;
+
 template <bool, class = void>
 struct enable_if
 {};
@@ -390,6 +399,14 @@ template <class T>
 struct is_object : negation<disjunction<is_function<T>, is_reference<T>, is_void<T>>>
 {};
 
+template <class T>
+struct is_trivially_copyable : bool_constant<__is_trivially_copyable(T)>
+{};
+
+template <class Base, class Derived>
+struct is_base_of : bool_constant<__is_base_of(Base, Derived)>
+{};
+
 template <class, class>
 struct is_same_template : false_type
 {};
@@ -480,6 +497,17 @@ union _max_align_t
 
 using max_align_t = internal::_max_align_t;
 
+template <uint64_t MAX>
+struct smallest_uint
+{
+    using type = conditional_t<MAX <= 0xFFu, uint8_t,
+                               conditional_t<MAX <= 0xFFFFu, uint16_t,
+                                             conditional_t<MAX <= 0xFFFFFFFFu, uint32_t, uint64_t>>>;
+};
+
+template <uint64_t MAX>
+using smallest_uint_t = typename smallest_uint<MAX>::type;
+
 template <class First, class... Next>
 class largest
 {